@@ -1,19 +1,19 @@
 #include "game.h"
+#include "random.h"
 
 #include <random>
 
 struct AgentRandom {
 
     Game& m_game;
-    static inline std::vector<Action> actions;
+    static inline thread_local std::vector<Action> actions;
 
     AgentRandom(Game& game) :
         m_game(game)
     {
     }
 
-    std::random_device rd;
-    std::mt19937 eng{rd()};
+    Random::Rng eng{ Random::stream(Random::Component::agent_random) };
 
     Action sample() {
         actions.clear();
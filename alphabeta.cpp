@@ -0,0 +1,308 @@
+#include "alphabeta.h"
+#include "types.h"
+#include "bitboard.h"
+#include "eval.h"
+#include "game.h"
+#include "race.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+
+namespace {
+
+    constexpr int infinite = AlphaBeta::win_score + 1;
+    constexpr int win_threshold = AlphaBeta::win_score - max_depth;
+
+    /// History scores saturate there, so that they stay below
+    /// the offsets of the captures and of the killers.
+    constexpr int history_max = 1 << 20;
+
+    /// Wins are stored relative to the node in the
+    /// table, and relative to the root in the search.
+    int score_to_tt(int score, int ply) {
+        return score >= win_threshold ? score + ply
+            : score <= -win_threshold ? score - ply
+            : score;
+    }
+    int score_from_tt(int score, int ply) {
+        return score >= win_threshold ? score - ply
+            : score <= -win_threshold ? score + ply
+            : score;
+    }
+
+}  // namespace
+
+
+AlphaBeta::AlphaBeta(Game& game)
+    : m_game{game}
+{
+    for (auto& actions : m_actions)
+        actions.reserve(max_n_moves);
+    set_tt_size(16);
+}
+
+/**
+ * Resize the transposition table to the largest power
+ * of two number of entries fitting in @mb megabytes.
+ */
+void AlphaBeta::set_tt_size(size_t mb) {
+    size_t n_entries = 1;
+    while (2 * n_entries * sizeof(TTEntry) <= (mb << 20))
+        n_entries *= 2;
+    m_table.assign(n_entries, TTEntry{});
+    clear();
+}
+
+/**
+ * Forget everything learned by previous searches.
+ */
+void AlphaBeta::clear() {
+    std::fill(m_table.begin(), m_table.end(), TTEntry{});
+    std::fill(&killers[0][0], &killers[0][0] + max_depth * 2, Action::none);
+    std::fill(&history[0][0], &history[0][0] + Nsquares * Nsquares, 0);
+    m_generation = 0;
+}
+
+TTEntry* AlphaBeta::probe(Key key, bool& found) {
+    TTEntry* entry = &m_table[key & (m_table.size() - 1)];
+    found = entry->bound != Bound::none && entry->key == key;
+    return entry;
+}
+
+/**
+ * Depth-preferred replacement: an entry is only overwritten by
+ * the same position, by a search at least as deep, or if it was
+ * written during a previous search.
+ */
+void AlphaBeta::store(TTEntry* entry, Key key, int score, Bound bound, int depth, Action action, int ply) {
+    if (entry->key != key && entry->generation == m_generation && entry->depth > depth)
+        return;
+
+    if (action == Action::none && entry->key == key)
+        action = entry->action;
+
+    *entry = TTEntry{ key, score_to_tt(score, ply), action, int8_t(depth), bound, m_generation };
+}
+
+bool AlphaBeta::is_capture(Action a) const {
+    return m_game.pieces(opposite_of(m_game.player_to_move())) & square_bb(to_square(a));
+}
+
+bool AlphaBeta::out_of_time() {
+    return std::chrono::steady_clock::now() - start_time >= time_limit;
+}
+
+/**
+ * Map static_eval()'s or the network's [0, 1] range
+ * to integer scores for the player to move.
+ */
+int AlphaBeta::evaluate() const {
+    double value = m_network ? m_network->evaluate(m_game) : static_eval(m_game);
+    return int((value - 0.5) * 2000);
+}
+
+/**
+ * Sort @actions by decreasing likelihood of causing a cutoff:
+ * the transposition table's action, captures, killers, then
+ * the rest according to their history score.
+ */
+void AlphaBeta::order_actions(std::vector<Action>& actions, Action tt_action, int ply) const {
+    std::pair<int, Action> scored[max_n_moves];
+    int n = 0;
+
+    for (Action a : actions) {
+        int score = a == tt_action          ? 1 << 30
+                  : is_capture(a)           ? (1 << 29) + history[to_integral(from_square(a))][to_integral(to_square(a))]
+                  : a == killers[ply][0]    ? (1 << 28) + 1
+                  : a == killers[ply][1]    ? (1 << 28)
+                  : history[to_integral(from_square(a))][to_integral(to_square(a))];
+        scored[n++] = { score, a };
+    }
+
+    std::stable_sort(scored, scored + n, [](const auto& a, const auto& b) {
+        return a.first > b.first;
+    });
+
+    for (int i = 0; i < n; ++i)
+        actions[i] = scored[i].second;
+}
+
+/**
+ * Principal variation search of the current position,
+ * returning a score from the point of view of the player to move.
+ */
+int AlphaBeta::search(int depth, int alpha, int beta, int ply) {
+    ++nodes_count;
+
+    // Our opponent reached our first row, or captured all our pieces
+    Color us = m_game.player_to_move();
+    if (m_game.is_lost() || !m_game.pieces(us))
+        return -win_score + ply;
+
+    // A piece one step away from its goal always has a winning move
+    if (ply > 0 && (m_game.pieces(us) & row_bb(relative(us, Row::seven))))
+        return win_score - ply - 1;
+
+    // So does a decided race, for either side
+    if (ply > 0) {
+        if (int plies = race(m_game, us).plies)
+            return win_score - ply - plies;
+        if (int plies = race(m_game, opposite_of(us)).plies)
+            return -win_score + ply + plies;
+    }
+
+    if (depth <= 0 || ply >= max_depth - 1)
+        return evaluate();
+
+    if ((nodes_count & 1023) == 0 && out_of_time())
+        stopped = true;
+    if (stopped)
+        return 0;
+
+    const bool pv_node = beta - alpha > 1;
+    const int alpha_orig = alpha;
+
+    bool found;
+    Key key = m_game.key();
+    TTEntry* entry = probe(key, found);
+    Action tt_action = Action::none;
+
+    if (found) {
+        ++tt_hits_count;
+        tt_action = entry->action;
+        int tt_score = score_from_tt(entry->score, ply);
+
+        if (!pv_node && ply > 0 && entry->depth >= depth
+            && (entry->bound == Bound::exact
+                || (entry->bound == Bound::lower && tt_score >= beta)
+                || (entry->bound == Bound::upper && tt_score <= alpha)))
+            return tt_score;
+    }
+
+    auto& actions = m_actions[ply];
+    m_game.compute_valid_actions(actions);
+
+    // No pieces left
+    if (actions.empty())
+        return -win_score + ply;
+
+    order_actions(actions, tt_action, ply);
+
+    int best_score = -infinite;
+    Action best = Action::none;
+
+    for (size_t i = 0; i < actions.size(); ++i) {
+        Action a = actions[i];
+        bool capture = is_capture(a);
+        int score;
+
+        m_game.apply(a, m_states[ply]);
+
+        // Full window for the first action, then try to prove the
+        // others are worse with a null window before re-searching
+        if (i == 0) {
+            score = -search(depth - 1, -beta, -alpha, ply + 1);
+        }
+        else {
+            score = -search(depth - 1, -alpha - 1, -alpha, ply + 1);
+            if (score > alpha && score < beta)
+                score = -search(depth - 1, -beta, -alpha, ply + 1);
+        }
+
+        m_game.undo(a);
+
+        if (stopped)
+            return 0;
+
+        if (score <= best_score)
+            continue;
+
+        best_score = score;
+        best = a;
+        if (ply == 0)
+            root_best = a;
+
+        if (score <= alpha)
+            continue;
+
+        alpha = score;
+        if (alpha >= beta) {
+            if (!capture) {
+                if (killers[ply][0] != a) {
+                    killers[ply][1] = killers[ply][0];
+                    killers[ply][0] = a;
+                }
+                int& h = history[to_integral(from_square(a))][to_integral(to_square(a))];
+                h = std::min(h + depth * depth, history_max);
+            }
+            break;
+        }
+    }
+
+    Bound bound = best_score >= beta      ? Bound::lower
+                : best_score > alpha_orig ? Bound::exact
+                : Bound::upper;
+    store(entry, key, best_score, bound, depth, best, ply);
+
+    return best_score;
+}
+
+/**
+ * Search the current position with iterative deepening until the
+ * time limit or the maximal depth is reached, or a win is proven.
+ *
+ * The action returned is the best one of the deepest iteration,
+ * including the last (interrupted) one.
+ *
+ * The history scores of the previous searches are halved, so that
+ * those of the current position weigh more.
+ */
+Action AlphaBeta::best_action() {
+    reset_counters();
+    start_time = std::chrono::steady_clock::now();
+    stopped = false;
+    ++m_generation;
+    for (auto& h : history)
+        for (int& score : h)
+            score /= 2;
+
+    m_game.compute_valid_actions(m_actions[0]);
+    assert(!m_actions[0].empty());
+    root_best = m_actions[0][0];
+    root_score = 0;
+
+    for (int depth = 1; depth <= max_search_depth; ++depth) {
+        int score = search(depth, -infinite, infinite, 0);
+
+        if (stopped)
+            break;
+
+        depth_reached = depth;
+        root_score = score;
+        if (std::abs(score) >= win_threshold)
+            break;
+    }
+
+    elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time).count();
+
+    return root_best;
+}
+
+void AlphaBeta::print_counters(std::ostream& out) const {
+    out << "Depth: " << depth_reached << '\n'
+        << "Nodes: " << nodes_count << '\n'
+        << "TT hits: " << tt_hits_count << '\n'
+        << "Time: " << elapsed_ms << "ms\n"
+        << "Nodes/sec: " << nodes_per_sec() << '\n'
+        << std::endl;
+}
+
+void AlphaBeta::reset_counters() {
+    nodes_count = 0;
+    tt_hits_count = 0;
+    depth_reached = 0;
+    elapsed_ms = 0;
+}
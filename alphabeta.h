@@ -0,0 +1,82 @@
+#ifndef ALPHABETA_H_
+#define ALPHABETA_H_
+
+#include "types.h"
+#include "game.h"
+#include "nnue.h"
+
+#include <chrono>
+#include <iosfwd>
+#include <vector>
+
+
+enum class Bound : uint8_t {
+    none, upper, lower, exact
+};
+
+struct TTEntry {
+    Key key;
+    int score;
+    Action action;
+    int8_t depth;
+    Bound bound;
+    uint8_t generation;
+};
+
+/**
+ * Iterative deepening Principal Variation Search
+ * using static_eval() at the leaves, or the network if one is set.
+ */
+class AlphaBeta {
+public:
+    AlphaBeta(Game& game);
+    Action best_action();
+
+    void set_max_depth(int d) { max_search_depth = d; }
+    void set_time_limit(int ms) { time_limit = std::chrono::milliseconds(ms); }
+    void set_network(const Nnue::Network* net) { m_network = net; }
+    void set_tt_size(size_t mb);
+    void clear();
+    void print_counters(std::ostream&) const;
+    void reset_counters();
+    long nodes_per_sec() const { return elapsed_ms > 0 ? 1000 * nodes_count / elapsed_ms : nodes_count; }
+    long n_nodes() const { return nodes_count; }
+    int score() const { return root_score; }
+
+    static constexpr int win_score = 100000;
+
+private:
+    int search(int depth, int alpha, int beta, int ply);
+    int evaluate() const;
+    void order_actions(std::vector<Action>& actions, Action tt_action, int ply) const;
+    bool is_capture(Action a) const;
+    bool out_of_time();
+
+    TTEntry* probe(Key key, bool& found);
+    void store(TTEntry* entry, Key key, int score, Bound bound, int depth, Action action, int ply);
+
+    Game& m_game;
+    StateData m_states[max_depth];
+    std::vector<Action> m_actions[max_depth];
+    std::vector<TTEntry> m_table;
+    uint8_t m_generation = 0;
+    const Nnue::Network* m_network = nullptr;
+
+    Action killers[max_depth][2];
+    int history[Nsquares][Nsquares];
+
+    int max_search_depth = 64;
+    std::chrono::milliseconds time_limit{ 100 };
+    std::chrono::steady_clock::time_point start_time;
+    bool stopped = false;
+    Action root_best = Action::none;
+    // Score of root_best at the deepest finished iteration
+    int root_score = 0;
+
+    long nodes_count = 0;
+    long tt_hits_count = 0;
+    int depth_reached = 0;
+    long elapsed_ms = 0;
+};
+
+#endif // ALPHABETA_H_
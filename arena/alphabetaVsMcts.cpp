@@ -0,0 +1,90 @@
+#include "game.h"
+#include "alphabeta.h"
+#include "mcts.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+
+constexpr int default_n_battles = 10;
+constexpr auto exp_cst = 0.7;
+constexpr auto n_mcts_iterations = 300;
+constexpr auto n_initial_samples = 1;
+constexpr auto alphabeta_time_ms = 100;
+
+int main(int argc, char *argv[]) {
+    Game::init();
+    Game game{};
+    StateData states[max_depth];
+    StateData* sd = &states[0];
+
+    int n_battles = argc > 1 ? std::stoi(argv[1]) : default_n_battles;
+
+    int alphabeta_wins_white = 0;
+    int alphabeta_wins_black = 0;
+
+    Mcts mcts(game);
+    mcts.set_exp_cst(exp_cst);
+    mcts.set_n_init_samples(n_initial_samples);
+    mcts.set_n_iterations(n_mcts_iterations);
+
+    AlphaBeta alphabeta(game);
+    alphabeta.set_time_limit(alphabeta_time_ms);
+
+    long alphabeta_moves = 0;
+    long alphabeta_nps = 0;
+    double time_mcts = 0.0;
+    long mcts_moves = 0;
+
+    for (int i=0; i<n_battles; ++i) {
+        game.reset();
+        sd = &states[0];
+        mcts.reset(game);
+        alphabeta.clear();
+
+        Color alphabeta_color = i & 1 ? Color::white : Color::black;
+
+        while (!game.is_lost()) {
+            Action action;
+
+            if (game.player_to_move() == alphabeta_color) {
+                action = alphabeta.best_action();
+                alphabeta_nps += alphabeta.nodes_per_sec();
+                ++alphabeta_moves;
+            }
+            else {
+                auto start = std::chrono::steady_clock::now();
+                action = mcts.best_action();
+                time_mcts += std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+                ++mcts_moves;
+            }
+
+            game.apply(action, *sd++);
+        }
+
+        if (game.player_to_move() != alphabeta_color) {
+            ++(alphabeta_color == Color::white ? alphabeta_wins_white : alphabeta_wins_black);
+            std::cerr << "AGENT_ALPHABETA wins!" << std::endl;
+        }
+        else {
+            std::cerr << "AGENT_MCTS wins!" << std::endl;
+        }
+    }
+
+    std::cout << "**** AGENT_ALPHABETA vs AGENT_MCTS ["
+        << n_battles
+        << " battles]\n"
+        << alphabeta_wins_white << " wins as white "
+        << alphabeta_wins_black << " wins as black\n"
+        << "    Winrate: "
+        << 100.0 * (alphabeta_wins_white + alphabeta_wins_black) / n_battles << "%"
+        << std::endl;
+
+    std::cout << "\nAlphaBeta time per move: " << alphabeta_time_ms << "ms"
+        << "\nAlphaBeta nodes/sec: " << (alphabeta_moves ? alphabeta_nps / alphabeta_moves : 0)
+        << "\nMcts n_iterations: " << n_mcts_iterations
+        << "\nMcts time per move: " << (mcts_moves ? time_mcts / mcts_moves : 0.0) << "ms"
+        << std::endl;
+}
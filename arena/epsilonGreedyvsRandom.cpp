@@ -2,7 +2,9 @@
 #include "epsilonGreedy.h"
 #include "agentRandom.h"
 
+#include <chrono>
 #include <iostream>
+#include <string>
 #include <unordered_map>
 #include <random>
 #include <vector>
@@ -17,27 +19,38 @@ int main(int argc, char *argv[]) {
     StateData states[max_depth];
     StateData* sd = &states[0];
 
-    int n_battles = default_n_battles;
-
-    if (argc > 1)
-        int n_battles = std::stoi(argv[1]);
+    int n_battles = argc > 1 ? std::stoi(argv[1]) : default_n_battles;
+    int n_threads = argc > 2 ? std::stoi(argv[2]) : 1;
 
     int n_wins_white = 0;
     int n_wins_black = 0;
+    double time_agent = 0.0;
+    long agent_moves = 0;
 
     for (int i=0; i<n_battles; ++i) {
         game.reset();
         sd = &states[0];
 
         Agent agent(game);
+        agent.set_n_threads(n_threads);
         AgentRandom agent_random(game);
 
         Color agent_color = i & 1 ? Color::white : Color::black;
 
         while (!game.is_lost()) {
-            Action action = game.player_to_move() == agent_color
-                ? agent.best_action()
-                : agent_random.best_action();
+            Action action;
+
+            if (game.player_to_move() == agent_color) {
+                auto start = std::chrono::steady_clock::now();
+                action = agent.best_action();
+                time_agent += std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+                ++agent_moves;
+            }
+            else {
+                action = agent_random.best_action();
+            }
+
             game.apply(action, *sd++);
         }
 
@@ -58,4 +71,8 @@ int main(int argc, char *argv[]) {
         << "    Winrate: "
         << 100.0 * (n_wins_white + n_wins_black) / n_battles << "%."
         << std::endl;
+
+    std::cout << "\nThreads: " << n_threads
+        << "\nTime per move: " << (agent_moves ? time_agent / agent_moves : 0.0) << "ms"
+        << std::endl;
 }
@@ -0,0 +1,78 @@
+#include "game.h"
+#include "mcts.h"
+
+#include <iostream>
+#include <string>
+
+
+constexpr int default_n_battles = 10;
+constexpr auto default_minimax_weight = 0.3;
+constexpr auto exp_cst = 0.7;
+constexpr auto n_mcts_iterations = 300;
+constexpr auto n_initial_samples = 1;
+
+/**
+ * Mcts blending implicit minimax values into UCB against plain Mcts,
+ * both with the same iteration budget.
+ *
+ * The tree is reset before every move, so that neither of
+ * them reuses its tree.
+ */
+int main(int argc, char *argv[]) {
+    Game::init();
+    Game game{};
+    StateData states[max_depth];
+    StateData* sd = &states[0];
+
+    int n_battles = argc > 1 ? std::stoi(argv[1]) : default_n_battles;
+    double minimax_weight = argc > 2 ? std::stod(argv[2]) : default_minimax_weight;
+
+    int minimax_wins_white = 0;
+    int minimax_wins_black = 0;
+
+    Mcts minimax(game);
+    Mcts plain(game);
+
+    for (Mcts* mcts : { &minimax, &plain }) {
+        mcts->set_exp_cst(exp_cst);
+        mcts->set_n_init_samples(n_initial_samples);
+        mcts->set_n_iterations(n_mcts_iterations);
+    }
+    minimax.set_minimax_weight(minimax_weight);
+
+    for (int i=0; i<n_battles; ++i) {
+        game.reset();
+        sd = &states[0];
+
+        Color minimax_color = i & 1 ? Color::white : Color::black;
+
+        while (!game.is_lost()) {
+            Mcts& mcts = game.player_to_move() == minimax_color ? minimax : plain;
+            mcts.reset(game);
+
+            game.apply(mcts.best_action(), *sd++);
+        }
+
+        if (game.player_to_move() != minimax_color) {
+            ++(minimax_color == Color::white ? minimax_wins_white : minimax_wins_black);
+            std::cerr << "AGENT_MCTS_MINIMAX wins!" << std::endl;
+        }
+        else {
+            std::cerr << "AGENT_MCTS wins!" << std::endl;
+        }
+    }
+
+    std::cout << "**** AGENT_MCTS_MINIMAX vs AGENT_MCTS ["
+        << n_battles
+        << " battles]\n"
+        << minimax_wins_white << " wins as white "
+        << minimax_wins_black << " wins as black\n"
+        << "    Winrate: "
+        << 100.0 * (minimax_wins_white + minimax_wins_black) / n_battles << "%"
+        << std::endl;
+
+    std::cout << "\nn_iterations: " << n_mcts_iterations
+        << "\nexploration constant: " << exp_cst
+        << "\nn_initial_samples: " << n_initial_samples
+        << "\nminimax weight: " << minimax_weight << std::endl;
+}
@@ -1,15 +1,18 @@
 #include "game.h"
 #include "epsilonGreedy.h"
 #include "mcts.h"
+#include "latency.h"
 
 #include <chrono>
 #include <iostream>
 #include <unordered_map>
 #include <random>
+#include <string>
 #include <vector>
 
 
 constexpr int default_n_battles = 10;
+constexpr double default_deadline_ms = 100.0;
 constexpr auto exp_cst = 0.7;
 constexpr auto n_mcts_iterations = 300;
 constexpr auto n_initial_samples = 1;
@@ -20,10 +23,8 @@ int main(int argc, char *argv[]) {
     StateData states[max_depth];
     StateData* sd = &states[0];
 
-    int n_battles = default_n_battles;
-
-    if (argc > 1)
-        int n_battles = std::stoi(argv[1]);
+    int n_battles = argc > 1 ? std::stoi(argv[1]) : default_n_battles;
+    double deadline_ms = argc > 2 ? std::stod(argv[2]) : default_deadline_ms;
 
     int mcts_wins_white = 0;
     int mcts_wins_black = 0;
@@ -33,8 +34,10 @@ int main(int argc, char *argv[]) {
     mcts.set_n_init_samples(n_initial_samples);
     mcts.set_n_iterations(n_mcts_iterations);
 
-    double total_avg_time_mcts = 0.0;
-    double total_avg_time_greedy = 0.0;
+    LatencyStats latency_mcts;
+    LatencyStats latency_greedy;
+    latency_mcts.set_deadline(deadline_ms);
+    latency_greedy.set_deadline(deadline_ms);
 
     for (int i=0; i<n_battles; ++i) {
         game.reset();
@@ -44,31 +47,18 @@ int main(int argc, char *argv[]) {
         Agent agent(game);
         mcts.reset(game);
 
-        int move_counter = 0;
-        double time_mcts = 0.0;
-        double time_greedy = 0.0;
-
         Color mcts_color = i & 1 ? Color::white : Color::black;
 
         Action action;
         while (!game.is_lost()) {
-            if (game.player_to_move() == mcts_color) {
-                auto start = std::chrono::steady_clock::now();
-                action = mcts.best_action();
-                time_mcts += std::chrono::duration_cast<std::chrono::milliseconds>(
-                    std::chrono::steady_clock::now() - start).count();
-            } else {
-                auto start = std::chrono::steady_clock::now();
-                action = agent.best_action();
-                time_greedy += std::chrono::duration_cast<std::chrono::milliseconds>(
-                    std::chrono::steady_clock::now() - start).count();
-            }
+            bool mcts_to_move = game.player_to_move() == mcts_color;
+            auto start = std::chrono::steady_clock::now();
+            action = mcts_to_move ? mcts.best_action() : agent.best_action();
+            (mcts_to_move ? latency_mcts : latency_greedy).record(
+                game.ply(), std::chrono::steady_clock::now() - start);
 
             game.apply(action, *sd++);
-            ++move_counter;
         }
-        total_avg_time_mcts += time_mcts;
-        total_avg_time_greedy += time_greedy;
 
         if (game.player_to_move() != mcts_color) {
             ++(mcts_color == Color::white ? mcts_wins_white : mcts_wins_black);
@@ -79,7 +69,7 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    std::cout << "**** AGENT_MCTS vs AGENT_EPSILON_GREEDY: "
+    std::cout << "**** AGENT_MCTS vs AGENT_EPSILON_GREEDY ["
         << n_battles
         << " battles]\n"
         << mcts_wins_white << " wins as white "
@@ -92,9 +82,8 @@ int main(int argc, char *argv[]) {
         << "\nexploration constant: " << exp_cst
         << "\nn_initial_samples: " << n_initial_samples << std::endl;
 
-    std::cout << "\nMCTS's Average time per move: "
-        << total_avg_time_mcts / n_battles << "ms"
-        << "AGENT_GREEDY's Average time per move: "
-        << total_avg_time_greedy / n_battles << "ms"
-        << std::endl;
+    std::cout << "\nAGENT_MCTS time per move:\n";
+    latency_mcts.print(std::cout);
+    std::cout << "\nAGENT_EPSILON_GREEDY time per move:\n";
+    latency_greedy.print(std::cout);
 }
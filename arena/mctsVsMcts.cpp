@@ -0,0 +1,85 @@
+#include "game.h"
+#include "mcts.h"
+
+#include <iostream>
+#include <string>
+
+
+constexpr int default_n_battles = 10;
+constexpr auto exp_cst = 0.7;
+constexpr auto n_mcts_iterations = 300;
+constexpr auto n_initial_samples = 1;
+
+/**
+ * Mcts using Sequential Halving at the root against Mcts using UCB,
+ * both with the same iteration budget.
+ *
+ * The tree is reset before every move, so that neither of
+ * them reuses its tree.
+ */
+int main(int argc, char *argv[]) {
+    Game::init();
+    Game game{};
+    StateData states[max_depth];
+    StateData* sd = &states[0];
+
+    int n_battles = argc > 1 ? std::stoi(argv[1]) : default_n_battles;
+
+    int halving_wins_white = 0;
+    int halving_wins_black = 0;
+    long halving_rollouts = 0;
+    long ucb_rollouts = 0;
+
+    Mcts halving(game);
+    Mcts ucb(game);
+
+    for (Mcts* mcts : { &halving, &ucb }) {
+        mcts->set_exp_cst(exp_cst);
+        mcts->set_n_init_samples(n_initial_samples);
+        mcts->set_n_iterations(n_mcts_iterations);
+    }
+    halving.set_root_policy(RootPolicy::sequential_halving);
+
+    for (int i=0; i<n_battles; ++i) {
+        game.reset();
+        sd = &states[0];
+
+        Color halving_color = i & 1 ? Color::white : Color::black;
+
+        while (!game.is_lost()) {
+            Mcts& mcts = game.player_to_move() == halving_color ? halving : ucb;
+            mcts.reset(game);
+
+            Action action = mcts.best_action();
+            (&mcts == &halving ? halving_rollouts : ucb_rollouts) += mcts.n_rollouts();
+
+            game.apply(action, *sd++);
+        }
+
+        if (game.player_to_move() != halving_color) {
+            ++(halving_color == Color::white ? halving_wins_white : halving_wins_black);
+            std::cerr << "AGENT_MCTS_HALVING wins!" << std::endl;
+        }
+        else {
+            std::cerr << "AGENT_MCTS_UCB wins!" << std::endl;
+        }
+    }
+
+    std::cout << "**** AGENT_MCTS_HALVING vs AGENT_MCTS_UCB ["
+        << n_battles
+        << " battles]\n"
+        << halving_wins_white << " wins as white "
+        << halving_wins_black << " wins as black\n"
+        << "    Winrate: "
+        << 100.0 * (halving_wins_white + halving_wins_black) / n_battles << "%"
+        << std::endl;
+
+    std::cout << "\nn_iterations: " << n_mcts_iterations
+        << "\nexploration constant: " << exp_cst
+        << "\nn_initial_samples: " << n_initial_samples << std::endl;
+
+    std::cout << "\nRollouts per game: "
+        << halving_rollouts / n_battles << " (halving), "
+        << ucb_rollouts / n_battles << " (ucb)"
+        << std::endl;
+}
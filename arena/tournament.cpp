@@ -0,0 +1,392 @@
+#include "game.h"
+#include "agentRandom.h"
+#include "alphabeta.h"
+#include "epsilonGreedy.h"
+#include "mcts.h"
+#include "latency.h"
+#include "random.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+constexpr int default_n_games = 1000;
+constexpr int default_opening_plies = 4;
+constexpr double default_sprt_alpha = 0.05;
+constexpr double default_sprt_beta = 0.05;
+
+const char* usage = R"(Usage: arena_tournament [options] <engine> <baseline>
+
+Play games between two engines on all cores and report the Elo
+difference of the first one. The colors alternate on each opening.
+
+Engines are given as kind[:key=value,...]:
+    random
+    greedy:iterations=5000,epsilon=0.1,init_samples=10,adaptive_samples=0,solver_threshold=0,threads=1
+    mcts:iterations=300,exp_cst=0.7,init_samples=1,adaptive_samples=0,minimax_weight=0,
+         expansion_threshold=1,halving=0,transposition_stats=0,symmetry=0,solver_threshold=0,memory_mb=0
+    alphabeta:time_ms=100,depth=64,tt_mb=16
+
+Options:
+    --games N           maximum number of games (1000)
+    --threads N         number of games played at once (all cores)
+    --opening-plies N   random plies played from the start position (4)
+    --seed N            seed of the openings and of the engines (2022)
+    --sprt ELO0,ELO1    stop when the SPRT of H0: elo = ELO0 against
+                        H1: elo = ELO1 is decided
+    --alpha A --beta B  error levels of the SPRT (0.05, 0.05)
+    --deadline-ms MS    count the moves which take longer than MS
+                        (no deadline by default)
+    --trace FILE        write the timeline of the searches of each thread
+                        in the Chrome trace format (last events only)
+)";
+
+/// One engine of the tournament, a new one is built for every game.
+class Player {
+public:
+    virtual ~Player() = default;
+    virtual Action best_action() = 0;
+};
+
+/// Kind and options of an engine, as given on the command line.
+struct Spec {
+    std::string text;
+    std::string kind;
+    std::map<std::string, std::string> options;
+};
+
+Spec parse_spec(const std::string& text) {
+    Spec spec{ text, text.substr(0, text.find(':')), {} };
+    if (text.find(':') == std::string::npos)
+        return spec;
+
+    std::string rest = text.substr(text.find(':') + 1);
+    while (!rest.empty()) {
+        std::string option = rest.substr(0, rest.find(','));
+        rest = rest.find(',') == std::string::npos ? "" : rest.substr(rest.find(',') + 1);
+        auto eq = option.find('=');
+        if (eq == std::string::npos)
+            throw std::invalid_argument("option without value in " + text);
+        spec.options[option.substr(0, eq)] = option.substr(eq + 1);
+    }
+    return spec;
+}
+
+/**
+ * Read the options of a Spec, checking that
+ * all of them are known to the engine.
+ */
+class Options {
+public:
+    explicit Options(const Spec& spec) : spec{ spec } {}
+
+    double get(const std::string& key, double default_value) {
+        used.push_back(key);
+        auto it = spec.options.find(key);
+        return it == spec.options.end() ? default_value : std::stod(it->second);
+    }
+
+    void check() const {
+        for (const auto& [key, value] : spec.options)
+            if (std::find(used.begin(), used.end(), key) == used.end())
+                throw std::invalid_argument("unknown option " + key + " in " + spec.text);
+    }
+
+private:
+    const Spec& spec;
+    std::vector<std::string> used;
+};
+
+class RandomPlayer : public Player {
+public:
+    RandomPlayer(Game& game, Options&) : agent{ game } {}
+    Action best_action() override { return agent.best_action(); }
+private:
+    AgentRandom agent;
+};
+
+class GreedyPlayer : public Player {
+public:
+    GreedyPlayer(Game& game, Options& opt) : agent{ game } {
+        agent.set_n_iterations(int(opt.get("iterations", 5000)));
+        agent.set_epsilon(opt.get("epsilon", 0.1));
+        agent.set_n_initial_samples(int(opt.get("init_samples", 10)));
+        agent.set_adaptive_samples(opt.get("adaptive_samples", 0));
+        agent.set_solver_threshold(int(opt.get("solver_threshold", 0)));
+        agent.set_n_threads(int(opt.get("threads", 1)));
+    }
+    Action best_action() override { return agent.best_action(); }
+private:
+    Agent agent;
+};
+
+class MctsPlayer : public Player {
+public:
+    MctsPlayer(Game& game, Options& opt) : mcts{ std::make_unique<Mcts>(game) } {
+        mcts->set_n_iterations(int(opt.get("iterations", 300)));
+        mcts->set_exp_cst(opt.get("exp_cst", 0.7));
+        mcts->set_n_init_samples(int(opt.get("init_samples", 1)));
+        mcts->set_adaptive_samples(opt.get("adaptive_samples", 0));
+        mcts->set_minimax_weight(opt.get("minimax_weight", 0.0));
+        mcts->set_expansion_threshold(int(opt.get("expansion_threshold", 1)));
+        mcts->set_root_policy(opt.get("halving", 0) ? RootPolicy::sequential_halving : RootPolicy::ucb);
+        mcts->set_transposition_stats(opt.get("transposition_stats", 0));
+        mcts->set_symmetry(opt.get("symmetry", 0));
+        mcts->set_solver_threshold(int(opt.get("solver_threshold", 0)));
+        mcts->set_memory_budget(size_t(opt.get("memory_mb", 0)));
+    }
+    Action best_action() override { return mcts->best_action(); }
+private:
+    std::unique_ptr<Mcts> mcts;
+};
+
+class AlphaBetaPlayer : public Player {
+public:
+    AlphaBetaPlayer(Game& game, Options& opt) : alphabeta{ std::make_unique<AlphaBeta>(game) } {
+        alphabeta->set_time_limit(int(opt.get("time_ms", 100)));
+        alphabeta->set_max_depth(int(opt.get("depth", 64)));
+        alphabeta->set_tt_size(size_t(opt.get("tt_mb", 16)));
+    }
+    Action best_action() override { return alphabeta->best_action(); }
+private:
+    std::unique_ptr<AlphaBeta> alphabeta;
+};
+
+std::unique_ptr<Player> make_player(const Spec& spec, Game& game) {
+    Options opt{ spec };
+    std::unique_ptr<Player> player;
+
+    if (spec.kind == "random")
+        player = std::make_unique<RandomPlayer>(game, opt);
+    else if (spec.kind == "greedy")
+        player = std::make_unique<GreedyPlayer>(game, opt);
+    else if (spec.kind == "mcts")
+        player = std::make_unique<MctsPlayer>(game, opt);
+    else if (spec.kind == "alphabeta")
+        player = std::make_unique<AlphaBetaPlayer>(game, opt);
+    else
+        throw std::invalid_argument("unknown engine " + spec.kind);
+
+    opt.check();
+    return player;
+}
+
+/**
+ * Play @n_plies random plies from the start position, the same
+ * ones for both games of the pair @pair.
+ */
+void play_opening(Game& game, StateData*& sd, int pair, int n_plies, unsigned seed) {
+    std::mt19937 eng{ seed + unsigned(pair) };
+    std::vector<Action> actions;
+
+    for (int i = 0; i < n_plies && !game.is_lost(); ++i) {
+        game.compute_valid_actions(actions);
+        game.apply(actions[eng() % actions.size()], *sd++);
+    }
+}
+
+/// Elo difference for an expected @score.
+double elo_of(double score) {
+    return 400.0 * std::log10(score / (1.0 - score));
+}
+
+/// Expected score for an Elo difference of @elo.
+double score_of(double elo) {
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+struct Results {
+    int wins = 0;
+    int losses = 0;
+
+    int games() const { return wins + losses; }
+
+    /// Elo difference and the half width of its 95% confidence interval.
+    std::pair<double, double> elo() const {
+        double n = games();
+        if (n == 0)
+            return { 0.0, 0.0 };
+        // Keep the estimate finite before the first win or loss
+        double score = std::clamp(wins / n, 0.5 / n, 1.0 - 0.5 / n);
+        double margin = 1.96 * std::sqrt(score * (1.0 - score) / n);
+        double low = elo_of(std::max(score - margin, 0.5 / n));
+        double high = elo_of(std::min(score + margin, 1.0 - 0.5 / n));
+        return { elo_of(score), (high - low) / 2 };
+    }
+
+    /// Log-likelihood ratio of H1: elo = @elo1 against H0: elo = @elo0.
+    double llr(double elo0, double elo1) const {
+        double p0 = score_of(elo0), p1 = score_of(elo1);
+        return wins * std::log(p1 / p0) + losses * std::log((1.0 - p1) / (1.0 - p0));
+    }
+};
+
+int main(int argc, char *argv[]) {
+    int n_games = default_n_games;
+    int n_threads = std::max(1u, std::thread::hardware_concurrency());
+    int opening_plies = default_opening_plies;
+    unsigned seed = 2022;
+    bool sprt = false;
+    double elo0 = 0.0, elo1 = 0.0;
+    double alpha = default_sprt_alpha, beta = default_sprt_beta;
+    std::vector<Spec> specs;
+    std::string trace_fp;
+    double deadline_ms = 0.0;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&] {
+                if (i + 1 >= argc)
+                    throw std::invalid_argument("missing value after " + arg);
+                return std::string(argv[++i]);
+            };
+
+            if (arg == "--games")              n_games = std::stoi(value());
+            else if (arg == "--threads")       n_threads = std::max(1, std::stoi(value()));
+            else if (arg == "--opening-plies") opening_plies = std::stoi(value());
+            else if (arg == "--seed")          seed = std::stoul(value());
+            else if (arg == "--alpha")         alpha = std::stod(value());
+            else if (arg == "--beta")          beta = std::stod(value());
+            else if (arg == "--deadline-ms")   deadline_ms = std::stod(value());
+            else if (arg == "--trace")         trace_fp = value();
+            else if (arg == "--sprt") {
+                std::string bounds = value();
+                sprt = true;
+                elo0 = std::stod(bounds.substr(0, bounds.find(',')));
+                elo1 = std::stod(bounds.substr(bounds.find(',') + 1));
+            }
+            else if (arg.rfind("--", 0) == 0)  throw std::invalid_argument("unknown option " + arg);
+            else                               specs.push_back(parse_spec(arg));
+        }
+        if (specs.size() != 2)
+            throw std::invalid_argument("two engines are needed");
+
+        // Fail before starting the threads on a wrong option
+        Game::init();
+        Game game;
+        for (const Spec& spec : specs)
+            make_player(spec, game);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n\n" << usage;
+        return EXIT_FAILURE;
+    }
+
+    const double lower_bound = std::log(beta / (1.0 - alpha));
+    const double upper_bound = std::log((1.0 - beta) / alpha);
+
+    Results results;
+    LatencyStats latencies[2];   // of the engine and of the baseline
+    std::mutex results_mutex;
+    std::atomic<int> next_game{ 0 };
+    std::atomic<bool> stop{ false };
+    for (auto& l : latencies)
+        l.set_deadline(deadline_ms);
+
+    Random::set_seed(seed);
+    if (!trace_fp.empty())
+        Trace::enable();
+
+    auto start = std::chrono::steady_clock::now();
+
+    auto worker = [&] {
+        Game game;
+        StateData states[max_depth];
+        LatencyStats thread_latencies[2];
+        for (auto& l : thread_latencies)
+            l.set_deadline(deadline_ms);
+
+        for (int g = next_game++; g < n_games && !stop; g = next_game++) {
+            game.reset();
+            StateData* sd = &states[0];
+            play_opening(game, sd, g / 2, opening_plies, seed);
+
+            // The engine plays white on the first game of each pair
+            Color engine_color = g & 1 ? Color::black : Color::white;
+            Random::set_thread_stream(g);
+            auto engine = make_player(specs[0], game);
+            auto baseline = make_player(specs[1], game);
+
+            while (!game.is_lost() && game.pieces(game.player_to_move())) {
+                const int p = game.player_to_move() == engine_color ? 0 : 1;
+                Player& player = p == 0 ? *engine : *baseline;
+                auto move_start = std::chrono::steady_clock::now();
+                Action action = player.best_action();
+                thread_latencies[p].record(game.ply(), std::chrono::steady_clock::now() - move_start);
+                game.apply(action, *sd++);
+            }
+
+            std::lock_guard lock{ results_mutex };
+            ++(game.player_to_move() != engine_color ? results.wins : results.losses);
+
+            auto [elo, margin] = results.elo();
+            std::cerr << "Game " << results.games() << ": "
+                      << results.wins << " - " << results.losses << std::fixed << std::setprecision(1)
+                      << "  Elo " << elo << " +/- " << margin;
+            if (sprt) {
+                double llr = results.llr(elo0, elo1);
+                std::cerr << std::setprecision(2) << "  LLR " << llr
+                          << " [" << lower_bound << ", " << upper_bound << "]";
+                if (llr <= lower_bound || llr >= upper_bound)
+                    stop = true;
+            }
+            std::cerr << std::endl;
+        }
+
+        std::lock_guard lock{ results_mutex };
+        for (int p = 0; p < 2; ++p)
+            latencies[p].merge(thread_latencies[p]);
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; ++t)
+        threads.emplace_back(worker);
+    for (auto& t : threads)
+        t.join();
+
+    if (!trace_fp.empty() && !Trace::dump(trace_fp))
+        return EXIT_FAILURE;
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    auto [elo, margin] = results.elo();
+
+    std::cout << "**** " << specs[0].text << " vs " << specs[1].text
+        << " [" << results.games() << " games]\n"
+        << results.wins << " wins " << results.losses << " losses\n" << std::fixed << std::setprecision(1)
+        << "    Winrate: " << 100.0 * results.wins / std::max(1, results.games()) << "%\n"
+        << "    Elo: " << elo << " +/- " << margin << " (95%)"
+        << std::endl;
+
+    if (sprt) {
+        double llr = results.llr(elo0, elo1);
+        std::cout << std::setprecision(2) << "    SPRT (" << elo0 << ", " << elo1 << "): LLR " << llr
+            << " [" << lower_bound << ", " << upper_bound << "] "
+            << (llr >= upper_bound ? "H1 accepted" : llr <= lower_bound ? "H0 accepted" : "undecided")
+            << std::endl;
+    }
+
+    for (int p = 0; p < 2; ++p) {
+        std::cout << "\nTime per move of " << specs[p].text << ":\n";
+        latencies[p].print(std::cout);
+    }
+
+    std::cout << std::fixed << std::setprecision(1)
+        << "\nThreads: " << n_threads
+        << "\nOpening plies: " << opening_plies
+        << "\nTime: " << seconds << "s (" << 60.0 * results.games() / seconds << " games/min)"
+        << std::endl;
+}
@@ -120,6 +120,17 @@ constexpr Bitboard flip_vertical(Bitboard bb) {
     return __builtin_bswap64(bb);
 }
 
+/**
+ * Mirror a bitboard accross the middle horizontally (column a <-> column h)
+ * by reversing the bits of each byte.
+ */
+constexpr Bitboard flip_horizontal(Bitboard bb) {
+    bb = ((bb >> 1) & 0x5555555555555555) | ((bb & 0x5555555555555555) << 1);
+    bb = ((bb >> 2) & 0x3333333333333333) | ((bb & 0x3333333333333333) << 2);
+    bb = ((bb >> 4) & 0x0F0F0F0F0F0F0F0F) | ((bb & 0x0F0F0F0F0F0F0F0F) << 4);
+    return bb;
+}
+
 /**
  * Count the number of set bits in a bitboard
  */
@@ -1,12 +1,19 @@
 #ifndef CONFIG_H_
 #define CONFIG_H_
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <iomanip>
+#include <optional>
+#include <string>
 #include <string_view>
+#include <type_traits>
 #include <fstream>
 #include <filesystem>
 
 #include "nlohmann/json.hpp"
+#include "eval.h"
 
 using json = nlohmann::json;
 namespace fs = std::filesystem;
@@ -26,31 +33,144 @@ struct Config {
         json j;
         ifs >> j;
 
-        std::cout << "Loading following config:\n"
+        std::cerr << "Loading following config:\n"
                   << std::setw(4) << j;
 
         iterations = j["iterations"];
-        exp_cst = j["exp_cst"];
-        init_samples = j["init_samples"];
+        time_ms = j["time_ms"];
+        seed = j["seed"];
+        for_each_param([&](std::string_view name, auto& value) {
+            value = j.at(pointer_of(name)).template get<std::decay_t<decltype(value)>>();
+        });
+        adaptive_samples = j["adaptive_samples"];
+        transposition_stats = j["transposition_stats"];
+        symmetry = j["symmetry"];
+        memory_budget_mb = j["memory_budget_mb"];
+        expansion_threshold = j["expansion_threshold"];
+        root_policy = j["root_policy"];
+        solver_threshold = j["solver_threshold"];
+        if (std::string dir = j["tablebase_dir"]; !dir.empty())
+            tablebase_dir = project_dir / dir;
+        if (std::string fn = j["nnue_file"]; !fn.empty())
+            nnue_file = project_dir / fn;
 
         dump_tree = j["dump_tree"];
         jsontree_datadir = project_dir / j["jsontree_datadir"];
         jsontree_fn = j["jsontree_fn"];
         max_nodes = j["max_nodes"];
 
-        std::cout << "Config successfully loaded" << std::endl;
+        std::cerr << "Config successfully loaded" << std::endl;
 
+        source = j;
         return true;
     }
 
+    /**
+     * Call @f(name, value) on every parameter which may be tuned,
+     * the name of a nested key joining its parents' with dots.
+     */
+    template<typename F>
+    void for_each_param(F f) {
+        f("exp_cst", exp_cst);
+        f("init_samples", init_samples);
+        f("minimax_weight", minimax_weight);
+        f("epsilon", epsilon);
+        f("epsilon_mid_ply", epsilon_mid_ply);
+        f("epsilon_mid_factor", epsilon_mid_factor);
+        f("epsilon_late_ply", epsilon_late_ply);
+        f("epsilon_late_factor", epsilon_late_factor);
+        f("eval.lever", eval.lever);
+        f("eval.structure", eval.structure);
+        f("eval.material", eval.material);
+        f("eval.phalanx", eval.phalanx);
+        f("eval.runner_in_3", eval.runner_in_3);
+        f("eval.threatened", eval.threatened);
+        f("eval.threatened_weight", eval.threatened_weight);
+    }
+
+    /// Value of the tunable parameter @name, if there is one.
+    std::optional<double> get(std::string_view name) {
+        std::optional<double> ret;
+        for_each_param([&](std::string_view n, auto& value) {
+            if (n == name)
+                ret = value;
+        });
+        return ret;
+    }
+
+    /// Set the tunable parameter @name, rounding it if it is an integer.
+    bool set(std::string_view name, double v) {
+        bool found = false;
+        for_each_param([&](std::string_view n, auto& value) {
+            if (n == name) {
+                value = std::is_integral_v<std::decay_t<decltype(value)>> ? std::lround(v) : v;
+                found = true;
+            }
+        });
+        return found;
+    }
+
+    /**
+     * The loaded configuration, with the current values
+     * of the tunable parameters.
+     */
+    json to_json() {
+        json j = source;
+        j["iterations"] = iterations;
+        j["time_ms"] = time_ms;
+        for_each_param([&](std::string_view name, auto& value) {
+            j[pointer_of(name)] = value;
+        });
+        return j;
+    }
+
+    bool save(const fs::path& fp) {
+        std::ofstream ofs{ fp };
+        if (!ofs)
+            return false;
+        ofs << std::setw(4) << to_json() << std::endl;
+        return bool(ofs);
+    }
+
     int iterations = 300;
+    int time_ms = 0;
+    // Seed of the random streams of the engines, see random.h,
+    // 0 for a different one on each run
+    uint64_t seed = 0;
     double exp_cst = 1.4;
     int init_samples = 1;
+    bool adaptive_samples = false;
+    bool transposition_stats = false;
+    bool symmetry = false;
+    int memory_budget_mb = 0;
+    int expansion_threshold = 1;
+    std::string root_policy = "ucb";
+    int solver_threshold = 0;
+    double minimax_weight = 0.0;
+    double epsilon = 0.1;
+    int epsilon_mid_ply = 32;
+    double epsilon_mid_factor = 0.5;
+    int epsilon_late_ply = 64;
+    double epsilon_late_factor = 0.25;
+    EvalWeights eval;
+    std::filesystem::path tablebase_dir = "";
+    std::filesystem::path nnue_file = "";
 
     bool dump_tree = false;
     std::filesystem::path jsontree_datadir = "view/data/jsontree";
     std::string jsontree_fn = "jsontree_ply_";
     int max_nodes = 1000;
+
+private:
+    json source;
+
+    /// JSON pointer to the tunable parameter @name.
+    static json::json_pointer pointer_of(std::string_view name) {
+        json::json_pointer pointer;
+        for (size_t dot; (dot = name.find('.')) != std::string_view::npos; name.remove_prefix(dot + 1))
+            pointer /= std::string(name.substr(0, dot));
+        return pointer / std::string(name);
+    }
 };
 
 std::pair<bool, Config> get_config(std::string_view fp = "default_config.json") {
@@ -1,63 +1,57 @@
-/// TODO: Extract as many hard-coded feature into a configurable parameter
-/// and write a helper script to tune them automatically.
-
 #include "types.h"
 #include "epsilonGreedy.h"
 #include "bitboard.h"
 #include "game.h"
+#include "race.h"
+#include "trace.h"
 
 #include <algorithm>
+#include <barrier>
+#include <chrono>
 #include <functional>
 #include <random>
 #include <iostream>
+#include <thread>
 
 
-namespace {
-
-    /// Globals
-    std::random_device rd;
-    std::mt19937 eng{rd()};
-
-}  // namespace
-
 struct TrueF {
     template<typename T>
     bool operator()(const T& t) { return true; }
 };
 
-template<typename Cont>
-typename Cont::value_type random_choice(Cont& cont) {
+template<typename Cont, typename Rng>
+typename Cont::value_type random_choice(Cont& cont, Rng& rng) {
     auto d = cont.size();
     std::uniform_int_distribution<> dist(0, d - 1);
-    return cont[dist(eng)];
+    return cont[dist(rng)];
 }
 
-template<typename Cont, typename F = TrueF>
-std::pair<bool, typename Cont::value_type> random_choice_with_predicate_old(Cont& cont, F f = TrueF{}) {
+template<typename Cont, typename Rng, typename F = TrueF>
+std::pair<bool, typename Cont::value_type> random_choice_with_predicate_old(Cont& cont, Rng& rng, F f = TrueF{}) {
     auto d = cont.size();
     std::uniform_int_distribution<> dist(0, d - 1);
-    auto ndx = dist(eng);
+    auto ndx = dist(rng);
     int c = 0;
 
     while (!f(cont[ndx]) && c < d - 1) {
         std::swap(cont[c], cont[ndx]);
         std::uniform_int_distribution<> nex_dist(++c, d - 1);
-        ndx = nex_dist(eng);
+        ndx = nex_dist(rng);
     }
 
     return std::make_pair(f(cont[ndx]), cont[ndx]);
 }
 
-template<typename Cont, typename F = TrueF>
-std::pair<bool, typename Cont::value_type> random_choice_with_predicate(Cont& cont, F f = TrueF{}) {
-    static std::vector<int> candidates_ndx;
+template<typename Cont, typename Rng, typename F = TrueF>
+std::pair<bool, typename Cont::value_type> random_choice_with_predicate(Cont& cont, Rng& rng, F f = TrueF{}) {
+    thread_local std::vector<int> candidates_ndx;
     candidates_ndx.clear();
     for (auto i = 0; i < cont.size(); ++i) {
         if (f(cont[i])) candidates_ndx.push_back(i);
     }
     if (candidates_ndx.empty())
         return std::make_pair(false, cont[0]);
-    auto ndx = random_choice(candidates_ndx);
+    auto ndx = random_choice(candidates_ndx, rng);
     return std::make_pair(true, cont[ndx]);
 }
 
@@ -65,93 +59,69 @@ std::pair<bool, typename Cont::value_type> random_choice_with_predicate(Cont& co
  * With probability @e, return false, and
  * with probability (1-@e), return true.
  */
-bool should_explore(double e) {
+template<typename Rng>
+bool should_explore(double e, Rng& rng) {
     std::uniform_real_distribution<> dist(0.0, 1.0);
-    if (dist(eng) > 1 - e)
+    if (dist(rng) > 1 - e)
         return true;
     return false;
 }
 
 /**
- * Evaluate the state of the game statically (without applying any action).
+ * Recursively play random actions drawn with @rng until the game
+ * is lost, starting with @a.
  *
- * Check for quick wins / losses, then consider the piece configuration on
- * both sides. Add bonus for phalanx, columns and levers that are protected
- * at least as many times as they are attacked.
+ * Invalidates @buffer.
  */
-double static_eval(const Game& game) {
-    int fastest_win_us = std::numeric_limits<int>::max();
-    int fastest_win_them = std::numeric_limits<int>::max();
+template<typename Rng>
+double playout(Game& game, Action a, std::vector<Action>& buffer, Rng& rng) {
 
-    Color us = game.player_to_move();
-    Color them = opposite_of(us);
-    Bitboard ours = game.pieces(us);
-    Bitboard theirs = game.pieces(them);
+    StateData sd;
+    game.apply(a, sd);
 
-    int our_score = 0;
-    int their_score = 0;
-    int lever_score = 0;
+    // Capturing the last piece of the opponent wins too,
+    // and leaves it without any action to draw from
+    if (game.is_lost() || !game.pieces(game.player_to_move())) {
+        // Report a winning score, weighted by the game ply.
+        // We put a big weight so that we don't return scores
+        // less than 0.5 even for very long winning lines.
+        game.undo(a);
+        return 1.0 - game.ply() / 300.0;
+    }
 
-    auto phalanx = [&game](Color c, Square sq) {
-        return bool(shift<Direction::left>(square_bb(sq)) & game.pieces(c));
-    };
-    auto column = [&game](Color c, Square sq) {
-        return bool(shift<Direction::up>(square_bb(sq)) & game.pieces(c));
-    };
-    auto protected_lever = [&game](Color c, Square sq) {
-        Bitboard lever = attacks_bb(c, sq) & game.pieces(c);
-        return count(attacks_bb(c, sq) & game.pieces(c))
-            >= count(attacks_bb(opposite_of(c), sq) & game.pieces(opposite_of(c)));
-    };
+    game.compute_valid_actions(buffer);
+    Action action = random_choice(buffer, rng);
 
-    while (ours && fastest_win_us > 1) {
-        Square sq = pop_lsb(ours);
-        if (count(span_bb(us, sq) & theirs) < 2) {
-            int plies_to_win = 7 - to_integral(relative(us, row_of(sq)));
-            if (plies_to_win < fastest_win_us) {
-                fastest_win_us = plies_to_win;
-            }
-        }
-        our_score += (2 * phalanx(us, sq)) + column(us, sq);
-        lever_score += 2 * protected_lever(us, sq);
-    }
-    if (fastest_win_us == 1)
-        return 1.0;
-
-    while (theirs && fastest_win_them > 2) {
-        Square sq = pop_lsb(theirs);
-        if (count(span_bb(them, sq) & ours) < 2) {
-            int plies_to_win = 7 - to_integral(relative(them, row_of(sq))) + 1;
-            if (plies_to_win < fastest_win_them) {
-                fastest_win_them = plies_to_win;
-            }
-        }
-        their_score += (2 * phalanx(them, sq)) + column(them, sq);
-        lever_score -= 2 * protected_lever(them, sq);
-    }
-    if (fastest_win_them == 2)
-        return 0.0;
-    if (fastest_win_us == 3)
-        return 0.8;
-
-    int my_count = count(game.pieces(us));
-    int their_count = count(game.pieces(them));
-    double material_score = 0.5 + (my_count - their_count) / (2.0 * (my_count + their_count));
-    double our_perf_score = 3 * my_count;
-    double their_perf_score = 3 * their_count;
-    double dlever_score = 0.5  + (lever_score + 16.0) / 16.0;
-    double score = (0.5 + (2.0 * our_score - our_perf_score) / (4.0 * our_perf_score)
-                    - (2.0 * their_score - their_perf_score) / (4.0 * their_perf_score));
-
-    if (fastest_win_them == 4)
-        return 0.33 * 0.35 + 0.33 * material_score + 0.33 * score;
-
-    return 0.2 * dlever_score + 0.3 * score + 0.5 * material_score;
+    // A win changes from 0.0 to 1.0 at each ply!
+    double reward = 1.0 - playout(game, action, buffer, rng);
+
+    game.undo(a);
+    return reward;
 }
 
+/**
+ * Run @n_iterations of the epsilon greedy sampling over @actions,
+ * exploring with probability @e and rolling out with @sample.
+ */
+template<typename Rng, typename F>
+void epsilon_greedy(std::vector<ExtAction>& actions, int n_iterations, double e, Rng& rng, F sample) {
+    for (int i=0; i<n_iterations; ++i) {
+        ExtAction* ra = nullptr;
+
+        if (should_explore(e, rng))
+            ra = &*std::find(actions.begin(), actions.end(), random_choice(actions, rng));
+        else
+            ra = &*std::min_element(actions.begin(), actions.end(), CmpActionsGreater{});
+
+        bool reward = sample(*ra);
+        ra->update(reward);
+    }
+}
 
 Agent::Agent(Game& game)
     : m_game{game}
+    , m_rng{Random::stream(Random::Component::agent)}
+    , m_solver{game}
 {}
 
 /**
@@ -173,26 +143,98 @@ double Agent::sample(Action action, int count) {
  * Invalidates @m_rollout_buffer.
  */
 double Agent::rollout(Action a) {
+    return playout(m_game, a, m_actions_buffer, m_rng);
+}
 
-    StateData sd{};
-    m_game.apply(a, sd);
-
-    if (m_game.is_lost()) {
-        // Report a winning score, weighted by the game ply.
-        // We put a big weight so that we don't return scores
-        // less than 0.5 even for very long winning lines.
-        m_game.undo(a);
-        return 1.0 - m_game.ply() / 300.0;
-    }
+/**
+ * Whether the sampling started at @start is over after @done
+ * iterations: when the time limit is reached if there is one,
+ * after @n_iterations otherwise.
+ */
+bool Agent::sampling_done(int done, std::chrono::steady_clock::time_point start) const {
+    return time_limit.count() > 0
+        ? std::chrono::steady_clock::now() - start >= time_limit
+        : done >= n_iterations;
+}
 
-    m_game.compute_valid_actions(m_actions_buffer);
-    Action action = random_choice(m_actions_buffer);
+/**
+ * Parallel version of the epsilon greedy sampling of the root actions,
+ * over @n_threads workers.
+ *
+ * The iterations are run in rounds of @batch_size per worker. Each
+ * worker owns a copy of the game, its buffers and a random engine seeded
+ * from the agent's, and samples from its own copy of the root statistics
+ * taken at the start of the round. The rollouts of all the workers are
+ * then merged into @root_actions, in the workers' order, before the next
+ * round: the result only depends on the seed and on @n_threads.
+ *
+ * The threads are started once per search, the calling one being the
+ * first worker, and wait for each other at the end of every round,
+ * when the last one to arrive merges the statistics.
+ */
+void Agent::parallel_epsilon_greedy(double e, std::chrono::steady_clock::time_point start) {
+    struct Worker {
+        Game game;
+        std::vector<Action> buffer;
+        Random::Rng rng;
+        std::vector<ExtAction> actions;
+    };
 
-    // A win changes from 0.0 to 1.0 at each ply!
-    double reward = 1.0 - rollout(action);
+    if (sampling_done(0, start))
+        return;
+
+    std::vector<Worker> workers;
+    workers.reserve(n_threads);
+    // The history of the game is shared, and only read by the workers
+    for (int t = 0; t < n_threads; ++t)
+        workers.push_back({ m_game, {}, Random::Rng{ m_rng() }, root_actions });
+
+    int done = 0;
+    bool over = false;
+    auto round_size = [&] {
+        return time_limit.count() > 0
+            ? batch_size
+            : std::min(batch_size, (n_iterations - done + n_threads - 1) / n_threads);
+    };
+    int per_worker = round_size();
+
+    // Merge the new statistics of every worker, then set up the next round
+    auto merge = [&]() noexcept {
+        Trace::Scope trace{ "merge", "agent" };
+        for (size_t i = 0; i < root_actions.size(); ++i) {
+            const ExtAction base = root_actions[i];
+            for (const auto& w : workers)
+                root_actions[i].update(w.actions[i].total_value - base.total_value,
+                                       w.actions[i].n_visits - base.n_visits);
+        }
+        done += per_worker * n_threads;
+        over = sampling_done(done, start);
+        if (!over) {
+            per_worker = round_size();
+            for (auto& w : workers)
+                w.actions = root_actions;
+        }
+    };
+    std::barrier sync{ n_threads, merge };
+
+    auto work = [&](Worker& w) {
+        while (!over) {
+            {
+                Trace::Scope trace{ "batch", "agent", per_worker };
+                epsilon_greedy(w.actions, per_worker, e, w.rng, [&w](Action a) {
+                    return playout(w.game, a, w.buffer, w.rng);
+                });
+            }
+            sync.arrive_and_wait();
+        }
+    };
 
-    m_game.undo(a);
-    return reward;
+    std::vector<std::thread> threads;
+    for (int t = 1; t < n_threads; ++t)
+        threads.emplace_back(work, std::ref(workers[t]));
+    work(workers[0]);
+    for (auto& t : threads)
+        t.join();
 }
 
 /**
@@ -222,7 +264,7 @@ Action Agent::defend_critical(Square th) {
     if (attackers) {
         if (count(attackers) - count(attackers_bb(them, th) & m_game.pieces(them)) > 0) {
             return random_choice_with_predicate(
-                root_actions,
+                root_actions, m_rng,
                 [&th](Action a){ return to_square(a) == th; }).second;
         }
     }
@@ -237,7 +279,7 @@ Action Agent::defend_critical(Square th) {
             : attacks<Color::white>(forward_free);
         if (!(prot & m_game.pieces(us))) {
             auto [found, action] = random_choice_with_predicate(
-                root_actions,
+                root_actions, m_rng,
                 [&prot](Action a){ return square_bb(to_square(a)) & prot; });
             if (found)
                 return action;
@@ -261,7 +303,7 @@ Action Agent::defend_critical(Square th) {
 
             ++n_open_diags;
             auto [found, action] = random_choice_with_predicate(
-                root_actions,
+                root_actions, m_rng,
                 [&diags_prot](Action a){ return square_bb(to_square(a)) & diags_prot; });
             if (found)
                 _action = action;
@@ -288,13 +330,36 @@ Action Agent::defend_critical(Square th) {
         if (c < smallest_span_count)
             smallest_span_count = c;
     }
-    Action action = random_choice_with_predicate(root_actions, [&] (Action a){
+    Action action = random_choice_with_predicate(root_actions, m_rng, [&] (Action a){
         return count(span_bb(us, from_square(a)) & m_game.pieces(them)) == smallest_span_count;
     }).second;
 
     return action;
 }
 
+/**
+ * Number of playouts behind the statistics of the root actions,
+ * 0 if the last move was found without sampling.
+ */
+long Agent::n_playouts() const {
+    long ret = 0;
+    for (const auto& ra : root_actions)
+        ret += ra.n_visits;
+    return ret;
+}
+
+/**
+ * Playouts and average reward of the root action @a for the player
+ * to move, { 0, 0.0 } if it was not sampled.
+ */
+std::pair<int, double> Agent::root_stats(Action a) const {
+    auto it = std::find_if(root_actions.begin(), root_actions.end(),
+                           [a](const ExtAction& ra) { return ra.action == a; });
+    if (it == root_actions.end() || it->n_visits == 0)
+        return { 0, 0.0 };
+    return { it->n_visits, it->total_value / it->n_visits };
+}
+
 /**
  * Pick the next action to play.
  *
@@ -304,47 +369,70 @@ Action Agent::defend_critical(Square th) {
  * candidate according to the agent's @cmpGreater.
  */
 Action Agent::best_action() {
+    Trace::Scope trace{ "search", "agent" };
     setup_rootactions();
 
     Color us = m_game.player_to_move();
     Color them = opposite_of(m_game.player_to_move());
 
-    double static_score = static_eval(m_game);
-
-    // If we have a win in 1
-    if (static_score > 0.8) {
-        Square sq = frontmost_sq(us, m_game.pieces(us));
+    // If we have a win in 1: any move from the row before the last wins
+    if (Square sq = frontmost_sq(us, m_game.pieces(us)); relative(us, row_of(sq)) == Row::seven) {
         return *find_if(root_actions.begin(), root_actions.end(), [&sq](const auto& ra) {
             return from_square(ra) == sq;
         });
     }
 
+    // Play a proven win if the endgame is small enough to be solved
+    if (solver_threshold > 0 && count(~m_game.no_pieces()) <= solver_threshold) {
+        SolverResult result = m_solver.solve();
+        if (result.proof == Proof::win)
+            return result.action;
+    }
+
+    // Run with a runner nothing can stop in time
+    if (RaceResult result = race(m_game, us); result.plies)
+        return result.action;
+
+    // Defending is pointless when the opponent has such a runner
     Bitboard critical = crit_rows(us) & m_game.pieces(them);
-    if (critical) {
+    if (critical && !race(m_game, them).plies) {
         Square th = frontmost_sq(them, m_game.pieces(them));
         auto action = defend_critical(frontmost_sq(them, m_game.pieces(them)));
         if (action != Action::none)
             return action;
     }
 
-    // Initial samples
-    for (auto& ra : root_actions) {
-        ra.total_value = sample(ra, n_initial_samples);
-        ra.n_visits = n_initial_samples;
+    // Initial samples, possibly spread towards the closest candidates
+    if (adaptive_samples) {
+        m_sample_stats.assign(root_actions.size(), SampleStats{});
+        adaptive_sample(m_sample_stats, n_initial_samples * int(root_actions.size()),
+                        [&](size_t i) { return sample(root_actions[i]); });
+        for (size_t i = 0; i < root_actions.size(); ++i) {
+            root_actions[i].total_value = m_sample_stats[i].total;
+            root_actions[i].n_visits = m_sample_stats[i].n;
+        }
+    }
+    else {
+        for (auto& ra : root_actions) {
+            ra.total_value = sample(ra, n_initial_samples);
+            ra.n_visits = n_initial_samples;
+        }
     }
 
     // epsilon-greedy exploitation/exploration
-    for (int i=0; i<n_iterations; ++i) {
-        ExtAction* ra = nullptr;
-
-        if (should_explore((m_game.ply() < 32 ? epsilon : m_game.ply() < 64 ? epsilon / 2 : epsilon / 4)))
-            ra = &*std::find(root_actions.begin(), root_actions.end(), random_choice(root_actions));
-        else
-            ra = &*std::min_element(root_actions.begin(), root_actions.end(), cmpGreater);
-
-        bool reward = sample(*ra);
-        ra->update(reward);
+    const auto start = std::chrono::steady_clock::now();
+    double e = m_game.ply() < epsilon_mid_ply ? epsilon
+             : m_game.ply() < epsilon_late_ply ? epsilon * epsilon_mid_factor
+             : epsilon * epsilon_late_factor;
+
+    if (n_threads > 1)
+        parallel_epsilon_greedy(e, start);
+    else if (time_limit.count() > 0) {
+        for (int done = 0; !sampling_done(done, start); done += batch_size)
+            epsilon_greedy(root_actions, batch_size, e, m_rng, [&](Action a) { return sample(a); });
     }
+    else
+        epsilon_greedy(root_actions, n_iterations, e, m_rng, [&](Action a) { return sample(a); });
 
     return *std::min_element(root_actions.begin(), root_actions.end(), cmpGreater);
 }
@@ -1,7 +1,13 @@
 #ifndef AGENT_H_
 #define AGENT_H_
 
+#include <chrono>
+#include <utility>
+
 #include "game.h"
+#include "random.h"
+#include "sampler.h"
+#include "solver.h"
 
 struct ExtAction {
     Action action;
@@ -30,21 +36,52 @@ public:
     Action best_action();
 
     void set_epsilon(double e) { epsilon = e; }
+    void set_epsilon_schedule(int mid_ply, double mid_factor, int late_ply, double late_factor) {
+        epsilon_mid_ply = mid_ply;
+        epsilon_mid_factor = mid_factor;
+        epsilon_late_ply = late_ply;
+        epsilon_late_factor = late_factor;
+    }
     void set_n_iterations(int n) { n_iterations = n; }
     void set_n_initial_samples(int n) { n_initial_samples = n; }
+    void set_adaptive_samples(bool b) { adaptive_samples = b; }
+    void set_solver_threshold(int n_pieces) { solver_threshold = n_pieces; }
+    void set_n_threads(int n) { n_threads = std::max(n, 1); }
+    void set_time_limit(int ms) { time_limit = std::chrono::milliseconds(ms); }
     double sample(Action a, int count=1);
+    long n_playouts() const;
+    std::pair<int, double> root_stats(Action a) const;
 
 private:
     Game& m_game;
     std::vector<ExtAction> root_actions;
     std::vector<Action> m_actions_buffer;
     std::vector<Action> m_rollout_buffer;
+    Random::Rng m_rng;
     CmpActionsGreater cmpGreater = CmpActionsGreater{};
     double epsilon = 0.1;
+    // Epsilon is scaled down by these factors from these plies on
+    int epsilon_mid_ply = 32;
+    double epsilon_mid_factor = 0.5;
+    int epsilon_late_ply = 64;
+    double epsilon_late_factor = 0.25;
     int n_iterations = 5000;
+    // Sample for that long instead of n_iterations if it is not 0
+    std::chrono::milliseconds time_limit{ 0 };
     int n_initial_samples = 10;
+    bool adaptive_samples = false;
+    std::vector<SampleStats> m_sample_stats;
+    Solver m_solver;
+    int solver_threshold = 0;
+
+    // Workers sampling the root actions, and their number of iterations
+    // between two merges of their statistics or two looks at the clock
+    int n_threads = 1;
+    static constexpr int batch_size = 64;
 
     void setup_rootactions();
+    bool sampling_done(int done, std::chrono::steady_clock::time_point start) const;
+    void parallel_epsilon_greedy(double e, std::chrono::steady_clock::time_point start);
     Action defend_critical(Square);
     double rollout(Action);
 };
@@ -0,0 +1,266 @@
+#include "eval.h"
+#include "types.h"
+#include "bitboard.h"
+#include "game.h"
+#include "race.h"
+
+#include <algorithm>
+#include <limits>
+
+
+namespace {
+
+    thread_local EvalWeights weights;
+
+    /**
+     * Number of plies before the fastest runner of color @c
+     * can reach its last row.
+     */
+    int fastest_runner(Color c, const Features& f) {
+        return f.runners ? 7 - to_integral(relative(c, row_of(frontmost_sq(c, f.runners))))
+                         : std::numeric_limits<int>::max();
+    }
+
+    /**
+     * Combine the features of both sides, whose pieces are
+     * @ours and @theirs, into the score of static_eval() with the weights @w.
+     */
+    double evaluate(Color us, const Features& f_us, const Features& f_them, Bitboard ours, Bitboard theirs,
+                    const EvalWeights& w) {
+        // A side without pieces has lost, and would divide by zero below
+        if (!theirs)
+            return 1.0;
+        if (!ours)
+            return 0.0;
+
+        int fastest_win_us = fastest_runner(us, f_us);
+        if (fastest_win_us == 1)
+            return 1.0;
+
+        // Races decided for either side
+        if (race(us, ours, theirs, f_us.runners, true).plies)
+            return 1.0;
+        if (race(opposite_of(us), theirs, ours, f_them.runners, false).plies)
+            return 0.0;
+
+        int fastest_win_them = fastest_runner(opposite_of(us), f_them);
+        if (fastest_win_them != std::numeric_limits<int>::max())
+            ++fastest_win_them;
+        if (fastest_win_them == 2)
+            return 0.0;
+        if (fastest_win_us == 3)
+            return w.runner_in_3;
+
+        int my_count = count(ours);
+        int their_count = count(theirs);
+        double our_score = w.phalanx * f_us.phalanx + f_us.column;
+        double their_score = w.phalanx * f_them.phalanx + f_them.column;
+        int lever_score = 2 * (f_us.levers - f_them.levers);
+
+        double material_score = 0.5 + (my_count - their_count) / (2.0 * (my_count + their_count));
+        double our_perf_score = 3 * my_count;
+        double their_perf_score = 3 * their_count;
+        double dlever_score = 0.5  + (lever_score + 16.0) / 16.0;
+        double score = (0.5 + (2.0 * our_score - our_perf_score) / (4.0 * our_perf_score)
+                        - (2.0 * their_score - their_perf_score) / (4.0 * their_perf_score));
+
+        // The lever term alone may exceed 1, keep the scores in [0, 1]
+        if (fastest_win_them == 4)
+            return std::clamp(w.threatened_weight * (w.threatened + material_score + score), 0.0, 1.0);
+
+        return std::clamp(w.lever * dlever_score + w.structure * score + w.material * material_score, 0.0, 1.0);
+    }
+
+    /// Four bitboards processed together, see features_avx2().
+    using Bitboard4 = Bitboard __attribute__((vector_size(32)));
+
+    /// Columns a to h, so that low_columns[d] holds the first @d of them.
+    constexpr Bitboard low_columns[8] = {
+        0, BB::ColA, BB::ColA | BB::ColB, BB::ColA | BB::ColB | BB::ColC,
+        BB::QueenSide, BB::QueenSide | BB::ColE, BB::QueenSide | BB::ColE | BB::ColF,
+        ~BB::ColH
+    };
+    constexpr Bitboard high_columns(int d) { return ~low_columns[8 - d]; }
+
+    /// Replace @b by the number of its pieces.
+    inline void popcount(Bitboard& b) { b = count(b); }
+
+    /**
+     * The functions on Bitboard4 update their argument rather than
+     * return a vector, whose ABI would depend on AVX being enabled.
+     */
+    [[gnu::always_inline]] inline void popcount(Bitboard4& x) {
+        Bitboard4 b = x - ((x >> 1) & 0x5555555555555555);
+        b = (b & 0x3333333333333333) + ((b >> 2) & 0x3333333333333333);
+        b = (b + (b >> 4)) & 0x0F0F0F0F0F0F0F0F;
+        b = b + (b >> 8);
+        b = b + (b >> 16);
+        b = b + (b >> 32);
+        x = b & 0x7F;
+    }
+    /// Flip the bitboards of @x vertically.
+    [[gnu::always_inline]] inline void flip(Bitboard4& x) {
+        Bitboard4 b = ((x >> 8) & 0x00FF00FF00FF00FF) | ((x & 0x00FF00FF00FF00FF) << 8);
+        b = ((b >> 16) & 0x0000FFFF0000FFFF) | ((b & 0x0000FFFF0000FFFF) << 16);
+        x = (b >> 32) | (b << 32);
+    }
+
+    /**
+     * Features of the pieces of @ours moving up the board, computed
+     * with shifts of whole bitboards only so that the same code runs on
+     * a single position (@B = Bitboard) or on four of them (Bitboard4).
+     *
+     * The runners are found by counting, up to two, the pieces of
+     * @theirs on each row ahead within the width of the span.
+     */
+    template<typename B>
+    [[gnu::always_inline]] inline void features(const B& ours, const B& theirs, B& phalanx, B& column, B& levers, B& runners) {
+        phalanx = ours & ((ours & ~BB::ColH) << 1);
+        popcount(phalanx);
+        column = ours & (ours >> 8);
+        popcount(column);
+
+        B o1 = (ours & ~BB::ColH) >> 7;
+        B o2 = (ours & ~BB::ColA) >> 9;
+        B t1 = (theirs & ~BB::ColH) << 9;
+        B t2 = (theirs & ~BB::ColA) << 7;
+        B outnumbered = (t1 & t2 & ~(o1 & o2)) | ((t1 | t2) & ~(o1 | o2));
+        levers = ours & ~outnumbered;
+        popcount(levers);
+
+        B any = ours & 0;
+        B two = ours & 0;
+        for (int k = 1; k < 8; ++k) {
+            B row = theirs >> (8 * k);
+            for (int d = -k; d <= k; ++d) {
+                B s = d > 0 ? (row & ~low_columns[d]) >> d
+                    : d < 0 ? (row & ~high_columns(-d)) << -d
+                    : row;
+                two |= any & s;
+                any |= s;
+            }
+        }
+        runners = ours & ~two;
+    }
+
+    Features make_features(Bitboard phalanx, Bitboard column, Bitboard levers, Bitboard runners) {
+        return { int8_t(phalanx), int8_t(column), int8_t(levers), runners };
+    }
+
+    /// Number of positions whose features are computed before being evaluated.
+    constexpr size_t block_size = 64;
+
+    /**
+     * Compute in @f the features of both colors of the positions
+     * [@begin, @end) of a batch, one position at a time.
+     */
+    void features_scalar(size_t begin, size_t end, const Bitboard* white, const Bitboard* black, Features (*f)[Ncolors]) {
+        for (size_t i = begin; i < end; ++i) {
+            Bitboard p[2], c[2], l[2], r[2];
+            features(white[i], black[i], p[0], c[0], l[0], r[0]);
+            features(flip_vertical(black[i]), flip_vertical(white[i]), p[1], c[1], l[1], r[1]);
+
+            f[i - begin][0] = make_features(p[0], c[0], l[0], r[0]);
+            f[i - begin][1] = make_features(p[1], c[1], l[1], flip_vertical(r[1]));
+        }
+    }
+
+#if defined(__x86_64__)
+    /**
+     * Same as features_scalar(), four positions at a time in
+     * the 64 bits lanes of AVX2 registers.
+     */
+    __attribute__((target("avx2")))
+    void features_avx2(size_t begin, size_t end, const Bitboard* white, const Bitboard* black, Features (*f)[Ncolors]) {
+        size_t i = begin;
+        for (; i + 4 <= end; i += 4) {
+            Bitboard4 w, b;
+            __builtin_memcpy(&w, white + i, sizeof(Bitboard4));
+            __builtin_memcpy(&b, black + i, sizeof(Bitboard4));
+
+            Bitboard4 p[2], c[2], l[2], r[2];
+            features(w, b, p[0], c[0], l[0], r[0]);
+            flip(w);
+            flip(b);
+            features(b, w, p[1], c[1], l[1], r[1]);
+            flip(r[1]);
+
+            for (int j = 0; j < 4; ++j) {
+                f[i + j - begin][0] = make_features(p[0][j], c[0][j], l[0][j], r[0][j]);
+                f[i + j - begin][1] = make_features(p[1][j], c[1][j], l[1][j], r[1][j]);
+            }
+        }
+        features_scalar(i, end, white, black, f + (i - begin));
+    }
+#endif
+
+    /**
+     * Evaluate a batch block by block: the features of a block are
+     * computed by @compute_features, then combined one position at a time.
+     */
+    template<typename F>
+    void batch(size_t n, const Bitboard* white, const Bitboard* black, const Color* side, double* out,
+               F compute_features) {
+        Features f[block_size][Ncolors];
+        const EvalWeights& w = weights;
+
+        for (size_t begin = 0; begin < n; begin += block_size) {
+            size_t end = std::min(n, begin + block_size);
+            compute_features(begin, end, white, black, f);
+
+            for (size_t i = begin; i < end; ++i) {
+                int us = to_integral(side[i]);
+                Bitboard pieces[2] = { white[i], black[i] };
+                out[i] = evaluate(side[i], f[i - begin][us], f[i - begin][1 - us], pieces[us], pieces[1 - us], w);
+            }
+        }
+    }
+
+}  // namespace
+
+/**
+ * Evaluate the state of the game statically (without applying any action).
+ *
+ * Check for quick wins / losses and decided races (see race()), then
+ * consider the piece configuration on both sides. Add bonus for phalanx,
+ * columns and levers that are protected at least as many times as they
+ * are attacked.
+ *
+ * The features are read from the game's states (see Game::features()),
+ * so the evaluation does not scan the pieces.
+ */
+double static_eval(const Game& game) {
+    Color us = game.player_to_move();
+    Color them = opposite_of(us);
+
+    return evaluate(us, game.features(us), game.features(them), game.pieces(us), game.pieces(them), weights);
+}
+
+void set_eval_weights(const EvalWeights& w) {
+    weights = w;
+}
+
+const EvalWeights& eval_weights() {
+    return weights;
+}
+
+/**
+ * Compute static_eval() of @n positions given in structure-of-arrays
+ * layout: position i has the pieces @white[i] and @black[i] and
+ * @side[i] to move. Uses AVX2 when the CPU supports it.
+ */
+void static_eval_batch(size_t n, const Bitboard* white, const Bitboard* black, const Color* side, double* out) {
+#if defined(__x86_64__)
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if (has_avx2)
+        return batch(n, white, black, side, out, features_avx2);
+#endif
+    batch(n, white, black, side, out, features_scalar);
+}
+
+/**
+ * Same as static_eval_batch(), one position at a time.
+ */
+void static_eval_batch_scalar(size_t n, const Bitboard* white, const Bitboard* black, const Color* side, double* out) {
+    batch(n, white, black, side, out, features_scalar);
+}
@@ -0,0 +1,74 @@
+#ifndef EVAL_H_
+#define EVAL_H_
+
+#include "types.h"
+#include "bitboard.h"
+
+#include <cstddef>
+#include <vector>
+
+
+class Game;
+
+/// Weights of the terms of static_eval().
+struct EvalWeights {
+    double lever = 0.2;             // Levers against the opponent's
+    double structure = 0.3;         // Phalanxes and columns against the opponent's
+    double material = 0.5;          // Piece count against the opponent's
+    double phalanx = 2.0;           // Structure value of a phalanx, relative to a column
+    double runner_in_3 = 0.8;       // Score when our fastest runner needs 3 plies
+    double threatened = 0.35;       // Base score when the opponent's runner needs 4 plies
+    double threatened_weight = 0.33;  // Weight of each term in that case
+};
+
+/**
+ * Weights used by static_eval() and static_eval_batch() on the calling
+ * thread, so that engines playing on different threads, or taking turns
+ * on the same one, may use their own.
+ */
+void set_eval_weights(const EvalWeights& w);
+const EvalWeights& eval_weights();
+
+/**
+ * Static evaluation of @game, in [0, 1] from the point
+ * of view of its player to move.
+ */
+double static_eval(const Game& game);
+
+void static_eval_batch(size_t n, const Bitboard* white, const Bitboard* black, const Color* side, double* out);
+void static_eval_batch_scalar(size_t n, const Bitboard* white, const Bitboard* black, const Color* side, double* out);
+
+/**
+ * Positions gathered for static_eval_batch(), each with the
+ * @index of the caller's item it stands for.
+ */
+struct EvalBatch {
+    std::vector<size_t> index;
+    std::vector<Bitboard> white, black;
+    std::vector<Color> side;
+    std::vector<double> values;
+
+    size_t size() const { return index.size(); }
+
+    void clear() {
+        index.clear();
+        white.clear();
+        black.clear();
+        side.clear();
+    }
+
+    void push(size_t i, Bitboard w, Bitboard b, Color c) {
+        index.push_back(i);
+        white.push_back(w);
+        black.push_back(b);
+        side.push_back(c);
+    }
+
+    /// Fill @values with the static_eval() of the positions.
+    void evaluate() {
+        values.resize(size());
+        static_eval_batch(size(), white.data(), black.data(), side.data(), values.data());
+    }
+};
+
+#endif // EVAL_H_
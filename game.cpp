@@ -1,8 +1,8 @@
 #include <algorithm>
 #include <cassert>
+#include <cctype>
 #include <iostream>
 #include <iterator>
-#include <random>
 #include <sstream>
 #include <string>
 #include <string_view>
@@ -10,10 +10,102 @@
 #include "types.h"
 #include "bitboard.h"
 #include "game.h"
+#include "random.h"
+#include "trace.h"
 
 
 namespace {
-    StateData root_sd{};
+
+    /**
+     * Squares having at least as many pieces of @ours on their two
+     * diagonals ahead (for @C) as pieces of @theirs on the two behind.
+     */
+    template<Color C>
+    Bitboard lever_squares(Bitboard ours, Bitboard theirs) {
+        constexpr bool white = C == Color::white;
+        Bitboard o1 = white ? shift<Direction::down_right>(ours) : shift<Direction::up_right>(ours);
+        Bitboard o2 = white ? shift<Direction::down_left>(ours) : shift<Direction::up_left>(ours);
+        Bitboard t1 = white ? shift<Direction::up_right>(theirs) : shift<Direction::down_right>(theirs);
+        Bitboard t2 = white ? shift<Direction::up_left>(theirs) : shift<Direction::down_left>(theirs);
+
+        // More of theirs: two against at most one, or one against none
+        Bitboard outnumbered = (t1 & t2 & ~(o1 & o2)) | ((t1 | t2) & ~(o1 | o2));
+        return ~outnumbered;
+    }
+
+    /**
+     * Features of the pieces of color @c on the board @bb, counting the
+     * phalanx, column and lever features of the pieces lying on @local
+     * and the runners lying on @spans.
+     */
+    Features features_on(Color c, const Bitboard (&bb)[Ncolors], Bitboard local, Bitboard spans) {
+        Bitboard ours = bb[to_integral(c)];
+        Bitboard theirs = bb[to_integral(opposite_of(c))];
+        Features f{};
+
+        f.phalanx = count(ours & local & shift<Direction::right>(ours));
+        f.column = count(ours & local & shift<Direction::down>(ours));
+        f.levers = count(ours & local & (c == Color::white ? lever_squares<Color::white>(ours, theirs)
+                                                             : lever_squares<Color::black>(ours, theirs)));
+
+        Bitboard pcs = ours & spans;
+        while (pcs) {
+            Square sq = pop_lsb(pcs);
+            Bitboard blockers = span_bb(c, sq) & theirs;
+            if ((blockers & (blockers - 1)) == 0)
+                f.runners |= square_bb(sq);
+        }
+
+        return f;
+    }
+
+    /**
+     * Set @before to the board before the move of @st, played by @us,
+     * given the board @after it.
+     */
+    void board_before(const StateData& st, Color us, const Bitboard (&after)[Ncolors], Bitboard (&before)[Ncolors]) {
+        const Square to = to_square(st.action);
+        const int i = to_integral(us);
+        before[i] = after[i] ^ square_bb(from_square(st.action)) ^ square_bb(to);
+        before[1 - i] = after[1 - i] | (st.capture ? square_bb(to) : 0);
+    }
+
+    /**
+     * Update the features of @st from the ones of its previous state, the
+     * move of @st being played by @us from the board @before to @after.
+     *
+     * The features which can change are those of the pieces next to the
+     * squares of the move, and the runners whose span contains exactly one
+     * of them (the span of the destination is included in the span of the
+     * origin) or the captured piece. The counts of the former are updated
+     * by difference, the runners are recomputed.
+     */
+    void replay_features(StateData& st, Color us, const Bitboard (&before)[Ncolors], const Bitboard (&after)[Ncolors]) {
+        const Color them = opposite_of(us);
+        const Square from = from_square(st.action);
+        const Square to = to_square(st.action);
+        const Bitboard move = square_bb(from) | square_bb(to);
+
+        Bitboard around = move | shift<Direction::left>(move) | shift<Direction::right>(move);
+        around |= shift<Direction::up>(around) | shift<Direction::down>(around);
+
+        Bitboard spans[Ncolors];
+        spans[to_integral(us)] = move | (st.capture ? span_bb(them, to) : 0);
+        spans[to_integral(them)] = (span_bb(us, from) & ~span_bb(us, to)) | move;
+
+        for (Color c : { us, them }) {
+            const int i = to_integral(c);
+            const Features& prev = st.prev->features[i];
+            Features removed = features_on(c, before, around, 0);
+            Features added = features_on(c, after, around, spans[i]);
+
+            st.features[i].phalanx = prev.phalanx + added.phalanx - removed.phalanx;
+            st.features[i].column = prev.column + added.column - removed.column;
+            st.features[i].levers = prev.levers + added.levers - removed.levers;
+            st.features[i].runners = (prev.runners & ~spans[i]) | added.runners;
+        }
+        st.features_computed = true;
+    }
 }  // namespace
 
 
@@ -24,10 +116,18 @@ namespace Zobrist {
 Key keyTable[Ncolors][Nsquares];
 Key side;
 
+constexpr uint64_t seed = 0x2022;
+
 inline Key key(Color c, Square sq) {
     return keyTable[to_integral(c)][to_integral(sq)];
 }
 
+/// Key of a piece on the reflection of @sq, used to
+/// maintain the key of the mirrored position.
+inline Key mirror_key(Color c, Square sq) {
+    return keyTable[to_integral(c)][to_integral(mirror(sq))];
+}
+
 }  // namespace Zobrist
 
 Game::Game()
@@ -35,6 +135,31 @@ Game::Game()
     reset();
 }
 
+/**
+ * A copy plays from its own copy of the current state, with its
+ * features brought up to date, so that it never writes to the states
+ * of @other, e.g. when they are used on different threads. The
+ * states before it are shared, and only read through the copy.
+ */
+Game::Game(const Game& other)
+{
+    *this = other;
+}
+
+Game& Game::operator=(const Game& other) {
+    std::copy(std::begin(other.m_board), std::end(other.m_board), std::begin(m_board));
+    std::copy(std::begin(other.by_color), std::end(other.by_color), std::begin(by_color));
+    root_sd = *other.sd;
+    sd = &root_sd;
+    m_ply = other.m_ply;
+    m_player_to_move = other.m_player_to_move;
+    m_action_buffer = other.m_action_buffer;
+
+    if (!sd->features_computed)
+        init_features();
+    return *this;
+}
+
 void Game::reset() {
     std::fill_n(std::begin(m_board), 16, Piece::white);
     std::fill_n(std::begin(m_board) + 16, 32, Piece::none);
@@ -59,16 +184,184 @@ void Game::reset() {
     for (Square sq = Square::a7; sq < Square::Nb; ++sq) {
         sd->key ^= Zobrist::key(Color::black, sq);
     }
+
+    // The starting position is symmetric
+    sd->mirror_key = sd->key;
+
+    init_features();
+}
+
+/**
+ * Setup an arbitrary position, e.g. to probe an endgame.
+ * The history of the game is lost.
+ */
+void Game::set_position(Bitboard white, Bitboard black, Color to_move) {
+    assert(!(white & black));
+
+    std::fill(std::begin(m_board), std::end(m_board), Piece::none);
+    by_color[to_integral(Color::white)] = white;
+    by_color[to_integral(Color::black)] = black;
+
+    m_ply = 0;
+    m_player_to_move = to_move;
+
+    sd = &root_sd;
+    sd->capture = false;
+    sd->action = Action::none;
+    sd->key = to_move == Color::black ? Zobrist::side : 0;
+    sd->mirror_key = sd->key;
+    sd->prev = nullptr;
+
+    for (Color c : { Color::white, Color::black }) {
+        Bitboard pcs = pieces(c);
+        while (pcs) {
+            Square sq = pop_lsb(pcs);
+            m_board[to_integral(sq)] = make_piece(c);
+            sd->key ^= Zobrist::key(c, sq);
+            sd->mirror_key ^= Zobrist::mirror_key(c, sq);
+        }
+    }
+
+    init_features();
+}
+
+/**
+ * Setup the position described by @notation, as written by notation():
+ * the rows from the eighth to the first separated by '/', with 'w' and
+ * 'b' for the pieces and digits for runs of empty squares, then a space
+ * and the player to move, 'w' or 'b'. The start position is
+ *
+ *     bbbbbbbb/bbbbbbbb/8/8/8/8/wwwwwwww/wwwwwwww w
+ *
+ * Return false, leaving the game as it was, if @notation is not valid.
+ */
+bool Game::set_position(std::string_view notation) {
+    Bitboard bb[Ncolors] = { 0, 0 };
+    int row = to_integral(Row::eight), col = 0;
+    size_t i = 0;
+
+    for (; i < notation.size() && notation[i] != ' '; ++i) {
+        char c = notation[i];
+        if (c == '/') {
+            if (col != 8 || row == 0)
+                return false;
+            --row;
+            col = 0;
+        }
+        else if (c >= '1' && c <= '8')
+            col += c - '0';
+        else if ((c == 'w' || c == 'b') && col < 8)
+            bb[c == 'b'] |= square_bb(square_at(Column(col++), Row(row)));
+        else
+            return false;
+
+        if (col > 8)
+            return false;
+    }
+    if (row != 0 || col != 8)
+        return false;
+
+    while (i < notation.size() && notation[i] == ' ')
+        ++i;
+    if (i >= notation.size() || (notation[i] != 'w' && notation[i] != 'b'))
+        return false;
+    Color to_move = notation[i++] == 'w' ? Color::white : Color::black;
+    while (i < notation.size() && std::isspace(static_cast<unsigned char>(notation[i])))
+        ++i;
+    if (i != notation.size())
+        return false;
+
+    set_position(bb[0], bb[1], to_move);
+    return true;
+}
+
+std::string Game::notation() const {
+    std::string ret;
+    for (int r = to_integral(Row::eight); r >= 0; --r) {
+        int empty = 0;
+        for (Square sq = square_at(Column::a, Row(r)); sq <= square_at(Column::h, Row(r)); ++sq) {
+            if (is_empty(sq)) {
+                ++empty;
+                continue;
+            }
+            if (empty)
+                ret += char('0' + empty);
+            empty = 0;
+            ret += piece_at(sq) == Piece::white ? 'w' : 'b';
+        }
+        if (empty)
+            ret += char('0' + empty);
+        if (r)
+            ret += '/';
+    }
+    ret += m_player_to_move == Color::white ? " w" : " b";
+    return ret;
+}
+
+/**
+ * Features of all the pieces of color @c, computed from scratch.
+ */
+Features Game::compute_features(Color c) const {
+    return features_on(c, by_color, ~Bitboard(0), ~Bitboard(0));
+}
+
+void Game::init_features() const {
+    for (Color c : { Color::white, Color::black })
+        sd->features[to_integral(c)] = compute_features(c);
+    sd->features_computed = true;
+}
+
+/**
+ * Bring the features of the current state up to date, by replaying the
+ * moves played since the last state where they were computed, or from
+ * scratch when that is cheaper. The states replayed on the way are
+ * brought up to date too, for the evaluations of their other children.
+ */
+void Game::update_features() const {
+    Color mover = opposite_of(m_player_to_move);
+
+    // Most often a single move behind, e.g. at the leaves of a search
+    if (sd->prev && sd->prev->features_computed) {
+        Bitboard before[Ncolors];
+        board_before(*sd, mover, by_color, before);
+        replay_features(*sd, mover, before, by_color);
+        return;
+    }
+
+    // Board of each state of the path, back to the last computed one
+    StateData* path[max_depth];
+    Bitboard boards[max_depth + 1][Ncolors];
+    const int n_pieces = count(~no_pieces());
+    int n = 0;
+    std::copy(std::begin(by_color), std::end(by_color), boards[0]);
+
+    for (StateData* st = sd; !st->features_computed; st = st->prev) {
+        // A move costs about as much as four pieces from scratch
+        if (!st->prev || 4 * (n + 1) > n_pieces) {
+            init_features();
+            return;
+        }
+        board_before(*st, mover, boards[n], boards[n + 1]);
+        path[n++] = st;
+        mover = opposite_of(mover);
+    }
+
+    for (int k = n - 1; k >= 0; --k) {
+        // The last move, path[0], was played by the opponent of the player to move
+        mover = k % 2 ? m_player_to_move : opposite_of(m_player_to_move);
+        replay_features(*path[k], mover, boards[k + 1], boards[k]);
+    }
 }
 
 void Game::init() {
     BB::init();
 
-    std::random_device rd;
-    std::mt19937 eng{rd()};
+    // The same keys on every run, so that the hashes, hence the order
+    // of the transposition tables, do not change the searches
+    Random::Rng eng{ Zobrist::seed };
 
     for (auto& i : Zobrist::keyTable)
-        for (unsigned int& j : i)
+        for (Key& j : i)
             j = eng();
 
     // for (int i=0; i<Ncolors; ++i)
@@ -79,12 +372,13 @@ void Game::init() {
 }
 
 void Game::turn_input(std::istream& ins, StateData& sd, bool store_actions) {
-    static std::string buf;
+    thread_local std::string buf;
     int n_legal_moves;
     buf.clear();
     m_action_buffer.clear();
 
     std::getline(ins, buf);
+    Trace::instant("input", "io");
     if (buf != "None") {
         Action move = action_of(buf);
         apply(move, sd);
@@ -125,7 +419,7 @@ std::string_view get_string(const Game& game, Action action);
 
 template<>
 std::string_view get_string<StringT::Rich>(const Game& game, Action action) {
-    static std::string view_buf;
+    thread_local std::string view_buf;
     std::ostringstream out;
 
     out << "\n            ply: " << game.ply() << "\n       "
@@ -155,7 +449,7 @@ std::string_view get_string<StringT::Rich>(const Game& game, Action action) {
 
 template<>
 std::string_view get_string<StringT::Raw>(const Game& game, Action action) {
-    static std::string view_buf;
+    thread_local std::string view_buf;
     std::ostringstream out;
 
     out << R"(\n            ply: )" << game.ply() << R"(\n       )"
@@ -205,7 +499,9 @@ void Game::apply(Action a, StateData& sd) {
 
     // Move the StateData object
     sd.key = this->sd->key;
+    sd.mirror_key = this->sd->mirror_key;
     sd.capture = false;
+    sd.features_computed = false;
     sd.action = a;
     sd.prev = this->sd;
     this->sd = &sd;
@@ -214,17 +510,52 @@ void Game::apply(Action a, StateData& sd) {
     if (pieces(opposite_of(m_player_to_move)) & square_bb(to)) {
         remove_piece(to);
         sd.key ^= Zobrist::key(opposite_of(m_player_to_move), to);
+        sd.mirror_key ^= Zobrist::mirror_key(opposite_of(m_player_to_move), to);
         sd.capture = true;
     }
 
     sd.key ^= Zobrist::key(m_player_to_move, from) ^ Zobrist::key(m_player_to_move, to);
     sd.key ^= Zobrist::side;
+    sd.mirror_key ^= Zobrist::mirror_key(m_player_to_move, from) ^ Zobrist::mirror_key(m_player_to_move, to);
+    sd.mirror_key ^= Zobrist::side;
 
     move_piece(from, to);
+
     m_player_to_move = opposite_of(m_player_to_move);
     ++m_ply;
 }
 
+/**
+ * Compute the key of the position reached after playing @a,
+ * without modifying the game.
+ */
+Key Game::key_after(Action a) const {
+    Square from = from_square(a);
+    Square to = to_square(a);
+    Key k = sd->key ^ Zobrist::side;
+
+    if (pieces(opposite_of(m_player_to_move)) & square_bb(to))
+        k ^= Zobrist::key(opposite_of(m_player_to_move), to);
+
+    return k ^ Zobrist::key(m_player_to_move, from) ^ Zobrist::key(m_player_to_move, to);
+}
+
+/**
+ * Same as key_after() but for the canonical orientation
+ * of the resulting position (see canonical_key()).
+ */
+Key Game::canonical_key_after(Action a) const {
+    Square from = from_square(a);
+    Square to = to_square(a);
+    Key mk = sd->mirror_key ^ Zobrist::side;
+
+    if (pieces(opposite_of(m_player_to_move)) & square_bb(to))
+        mk ^= Zobrist::mirror_key(opposite_of(m_player_to_move), to);
+
+    mk ^= Zobrist::mirror_key(m_player_to_move, from) ^ Zobrist::mirror_key(m_player_to_move, to);
+    return std::min(key_after(a), mk);
+}
+
 void Game::undo(Action a) {
     Square to = to_square(a);
     Square from = from_square(a);
@@ -1,8 +1,10 @@
 #ifndef GAME_H_
 #define GAME_H_
 
+#include <algorithm>
 #include <array>
 #include <iosfwd>
+#include <string>
 #include <string_view>
 #include <vector>
 
@@ -10,20 +12,41 @@
 #include "bitboard.h"
 
 
+/**
+ * Features of the pieces of one side used by static_eval(), only
+ * brought up to date when they are read (see Game::features()).
+ */
+struct Features {
+    int8_t phalanx;     // Pieces with a friendly piece on their left
+    int8_t column;      // Pieces with a friendly piece above them
+    int8_t levers;      // Pieces with at least as many friendly pieces ahead as enemy pieces behind on their diagonals
+    Bitboard runners;   // Pieces with less than two enemy pieces in their span
+    bool operator==(const Features&) const = default;
+};
+
 struct StateData {
     Key key;
+    Key mirror_key;
     bool capture;
+    // Whether @features are up to date
+    bool features_computed;
     Action action;
+    Features features[Ncolors];
     StateData* prev;
 };
 
 class Game {
 public:
     Game();
+    Game(const Game& other);
+    Game& operator=(const Game& other);
     static void init();
     void turn_input(std::istream&, StateData& sd, bool store_actions=false);
     [[nodiscard]] std::string_view view(Action=Action::none, bool raw=false) const;
     void reset();
+    void set_position(Bitboard white, Bitboard black, Color to_move);
+    bool set_position(std::string_view notation);
+    [[nodiscard]] std::string notation() const;
 
     void apply(Action, StateData& sd);
     void undo(Action a);
@@ -33,6 +56,12 @@ public:
     std::vector<Action>& valid_actions() { return m_action_buffer; }
     [[nodiscard]] constexpr Color player_to_move() const { return m_player_to_move; }
     [[nodiscard]] constexpr Key key() const { return sd->key; }
+    [[nodiscard]] Key key_after(Action a) const;
+    [[nodiscard]] constexpr Key canonical_key() const { return std::min(sd->key, sd->mirror_key); }
+    [[nodiscard]] constexpr bool is_mirrored() const { return sd->mirror_key < sd->key; }
+    [[nodiscard]] Key canonical_key_after(Action a) const;
+    [[nodiscard]] const Features& features(Color c) const;
+    [[nodiscard]] Features compute_features(Color c) const;
     constexpr StateData* get_sd() { return sd; }
     void set_sd(StateData* new_sd) { sd = new_sd; }
 
@@ -46,6 +75,9 @@ private:
     Piece m_board[Nsquares];
     Bitboard by_color[Ncolors];
     StateData* sd;
+    // State of the position set by reset() or set_position(), owned by
+    // each game so that games may be played on different threads
+    StateData root_sd{};
     int m_ply;
     Color m_player_to_move;
     std::vector<Action> m_action_buffer;
@@ -53,6 +85,8 @@ private:
     void remove_piece(Square);
     void put_piece(Piece, Square);
     void move_piece(Square from, Square to);
+    void init_features() const;
+    void update_features() const;
 };
 
 constexpr Piece Game::piece_at(Square s) const {
@@ -67,6 +101,11 @@ constexpr Bitboard Game::pieces(Color c) const {
 constexpr Bitboard Game::no_pieces() const {
     return ~(pieces(Color::white) | pieces(Color::black));
 }
+inline const Features& Game::features(Color c) const {
+    if (!sd->features_computed)
+        update_features();
+    return sd->features[to_integral(c)];
+}
 inline bool Game::is_lost() const {
     return pieces(opposite_of(m_player_to_move)) & row_bb(relative(m_player_to_move, Row::one));
 }
@@ -0,0 +1,166 @@
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <string>
+
+
+/**
+ * Distribution of the time taken by an engine to play its moves,
+ * split by phase of the game, with the moves played past a deadline.
+ *
+ * The times are kept in a log-linear histogram, 8 buckets per power
+ * of two of microseconds, so that the percentiles are exact to
+ * about 9% whatever the number of moves. The mean and the maximum
+ * are exact.
+ */
+class LatencyStats {
+public:
+    /// Phases of the game, by ply of the move
+    static constexpr int ply_bucket_size = 16;
+    static constexpr int n_ply_buckets = 4;
+
+    static constexpr int buckets_per_octave = 8;
+    static constexpr int n_buckets = 32 * buckets_per_octave;
+
+    struct Summary {
+        uint64_t n = 0;
+        uint64_t misses = 0;
+        double mean_ms = 0.0;
+        double p50_ms = 0.0, p90_ms = 0.0, p99_ms = 0.0, max_ms = 0.0;
+    };
+
+    /// A move counts as a miss when it takes longer than @ms, never when 0.
+    void set_deadline(double ms) { m_deadline_us = uint64_t(ms * 1000.0); }
+    [[nodiscard]] double deadline() const { return m_deadline_us / 1000.0; }
+
+    void record(int ply, std::chrono::nanoseconds elapsed) {
+        const uint64_t us = std::max<int64_t>(elapsed.count() / 1000, 0);
+        Phase& p = m_phases[ply_bucket(ply)];
+        ++p.histogram[bucket_of(us)];
+        ++p.n;
+        p.sum_us += us;
+        p.max_us = std::max(p.max_us, us);
+        if (m_deadline_us && us > m_deadline_us)
+            ++p.misses;
+    }
+
+    void merge(const LatencyStats& other) {
+        for (int b = 0; b < n_ply_buckets; ++b) {
+            Phase& p = m_phases[b];
+            const Phase& o = other.m_phases[b];
+            for (int i = 0; i < n_buckets; ++i)
+                p.histogram[i] += o.histogram[i];
+            p.n += o.n;
+            p.misses += o.misses;
+            p.sum_us += o.sum_us;
+            p.max_us = std::max(p.max_us, o.max_us);
+        }
+    }
+
+    /// Summary of the phase @ply_bucket, of the whole game when -1.
+    [[nodiscard]] Summary summary(int ply_bucket = -1) const {
+        Phase all;
+        const Phase* p = &all;
+        if (ply_bucket >= 0) {
+            p = &m_phases[ply_bucket];
+        }
+        else {
+            for (const Phase& phase : m_phases) {
+                for (int i = 0; i < n_buckets; ++i)
+                    all.histogram[i] += phase.histogram[i];
+                all.n += phase.n;
+                all.misses += phase.misses;
+                all.sum_us += phase.sum_us;
+                all.max_us = std::max(all.max_us, phase.max_us);
+            }
+        }
+
+        Summary s;
+        s.n = p->n;
+        s.misses = p->misses;
+        if (s.n == 0)
+            return s;
+        s.mean_ms = p->sum_us / 1000.0 / s.n;
+        s.max_ms = p->max_us / 1000.0;
+        s.p50_ms = percentile(*p, 0.50);
+        s.p90_ms = percentile(*p, 0.90);
+        s.p99_ms = percentile(*p, 0.99);
+        return s;
+    }
+
+    [[nodiscard]] static std::string phase_name(int ply_bucket) {
+        if (ply_bucket == n_ply_buckets - 1)
+            return "plies " + std::to_string(ply_bucket * ply_bucket_size) + "+";
+        return "plies " + std::to_string(ply_bucket * ply_bucket_size) + "-"
+            + std::to_string((ply_bucket + 1) * ply_bucket_size - 1);
+    }
+
+    void print(std::ostream& out) const {
+        out << std::left << std::setw(14) << "phase" << std::right
+            << std::setw(8) << "moves" << std::setw(10) << "mean" << std::setw(10) << "p50"
+            << std::setw(10) << "p90" << std::setw(10) << "p99" << std::setw(10) << "max"
+            << std::setw(9) << "misses" << "  (ms" << std::fixed << std::setprecision(1);
+        if (m_deadline_us)
+            out << ", deadline " << deadline();
+        out << ")\n";
+
+        auto print_row = [&](const std::string& name, const Summary& s) {
+            out << std::left << std::setw(14) << name << std::right
+                << std::setw(8) << s.n << std::setw(10) << s.mean_ms << std::setw(10) << s.p50_ms
+                << std::setw(10) << s.p90_ms << std::setw(10) << s.p99_ms << std::setw(10) << s.max_ms
+                << std::setw(9) << s.misses << '\n';
+        };
+        for (int b = 0; b < n_ply_buckets; ++b)
+            if (m_phases[b].n)
+                print_row(phase_name(b), summary(b));
+        print_row("all", summary());
+        out << std::defaultfloat;
+    }
+
+private:
+    struct Phase {
+        std::array<uint64_t, n_buckets> histogram{};
+        uint64_t n = 0;
+        uint64_t misses = 0;
+        uint64_t sum_us = 0;
+        uint64_t max_us = 0;
+    };
+
+    static int ply_bucket(int ply) {
+        return std::clamp(ply / ply_bucket_size, 0, n_ply_buckets - 1);
+    }
+
+    static int bucket_of(uint64_t us) {
+        return std::min(int(buckets_per_octave * std::log2(double(us) + 1.0)), n_buckets - 1);
+    }
+
+    /// Upper bound of the bucket @i, in microseconds
+    static double bucket_limit(int i) {
+        return std::exp2(double(i + 1) / buckets_per_octave) - 1.0;
+    }
+
+    /// Smallest bucket limit under which a fraction @q of the moves
+    /// fall, which can not be more than the slowest move.
+    static double percentile(const Phase& p, double q) {
+        const double target = std::ceil(q * p.n);
+        uint64_t seen = 0;
+        for (int i = 0; i < n_buckets; ++i) {
+            seen += p.histogram[i];
+            if (seen >= target)
+                return std::min(bucket_limit(i), double(p.max_us)) / 1000.0;
+        }
+        return p.max_us / 1000.0;
+    }
+
+    std::array<Phase, n_ply_buckets> m_phases{};
+    uint64_t m_deadline_us = 0;
+};
+
+#endif // LATENCY_H_
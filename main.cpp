@@ -1,16 +1,29 @@
 #include <cassert>
 #include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <string>
 
 #include "game.h"
 #include "epsilonGreedy.h"
+#include "latency.h"
+#include "random.h"
 
 constexpr double epsilon = 0.3;
 constexpr int n_iterations = 5000;
 constexpr int n_initial_samples = 10;
+/// Time allowed for the first move and for the next ones
+constexpr double first_move_deadline_ms = 1000.0;
+constexpr double move_deadline_ms = 100.0;
 
-int main() {
+/**
+ * Play the moves read from the standard input. The searches draw a seed
+ * unless one is given as the first argument, to reproduce a game.
+ */
+int main(int argc, char *argv[]) {
     Game::init();
+    if (argc > 1)
+        Random::set_seed(std::stoull(argv[1]));
 
     Game game;
     Agent agent(game);
@@ -22,13 +35,30 @@ int main() {
     agent.set_n_iterations(n_iterations);
     agent.set_n_initial_samples(n_initial_samples);
 
-    while (true) {
+    LatencyStats latency;
+    latency.set_deadline(first_move_deadline_ms);
+
+    while (std::cin.peek() != EOF) {
         game.turn_input(std::cin, *sd++);
+        auto start = std::chrono::steady_clock::now();
 
         Action action = agent.best_action();
         std::cout << string_of(action) << std::endl;
+
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        latency.record(game.ply(), elapsed);
+        latency.set_deadline(move_deadline_ms);
         game.apply(action, *sd++);
+
+        // The moves are timed up to their output, the time of the
+        // other player being left out
+        auto all = latency.summary();
+        std::cerr << "Move " << all.n << ": "
+            << std::chrono::duration<double, std::milli>(elapsed).count() << "ms"
+            << " (p50 " << all.p50_ms << ", p99 " << all.p99_ms << ", max " << all.max_ms
+            << ", " << all.misses << " over the deadline)" << std::endl;
     }
 
+    latency.print(std::cerr);
     return EXIT_SUCCESS;
 }
@@ -2,33 +2,64 @@
 #include "types.h"
 #include "bitboard.h"
 #include "game.h"
+#include "eval.h"
+#include "race.h"
+#include "trace.h"
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <iostream>
+#include <limits>
 #include <string>
 #include <string_view>
 #include <map>
 #include <sstream>
 #include <fstream>
 #include <random>
+#include <unordered_set>
 
 
-std::unordered_map<Key, Node> TTable;
-
 namespace {
-/// Globals
-    std::random_device rd;
-    std::mt19937 eng{rd()};
-    std::vector<Action> rollout_buffer;
+/// Globals, one copy per thread
+    thread_local std::vector<Action> rollout_buffer;
+
+/// Iterations per span of the trace
+    constexpr int trace_batch = 256;
+#ifdef BT_PROFILE
+    // Plies of the current playout
+    thread_local int rollout_plies;
+#endif
+
+/// Approximate footprint of an entry of the table, counting
+/// the hash node and its bucket on top of the Node itself.
+    constexpr size_t node_footprint = sizeof(std::pair<const Key, Node>) + 2 * sizeof(void*);
 }  // namespace
 
-template<typename Cont>
-typename Cont::value_type random_choice(Cont& cont) {
+template<typename Cont, typename Rng>
+typename Cont::value_type random_choice(Cont& cont, Rng& rng) {
     auto d = cont.size();
     std::uniform_int_distribution<> dist(0, d - 1);
-    return cont[dist(eng)];
+    return cont[dist(rng)];
+}
+
+/**
+ * Map @a between the orientation of the node stored for the
+ * position described by @st and the orientation in which that
+ * position is actually played. The reflection being an involution,
+ * the same method works in both directions.
+ */
+Action Mcts::oriented(Action a, const StateData& st) const {
+    return symmetry && st.mirror_key < st.key ? mirror(a) : a;
+}
+
+/**
+ * Key of the node reached from the current node through @edge.
+ */
+Key Mcts::child_key(const Edge& edge) const {
+    Action a = oriented(edge.action);
+    return symmetry ? m_game.canonical_key_after(a) : m_game.key_after(a);
 }
 
 /**
@@ -37,23 +68,32 @@ typename Cont::value_type random_choice(Cont& cont) {
  * with default values if not found).
  */
 Node* Mcts::get_node(Key key) {
-    return &TTable.try_emplace(key, key, 0).first->second;
+    BT_PROFILE_SCOPE(m_profile, get_node);
+    return &m_table.try_emplace(key, key, 0).first->second;
 }
 
 
 Mcts::Mcts(Game& game)
     : m_game(game)
+    , m_rng(Random::stream(Random::Component::mcts))
+    , m_solver(game)
 {
     reset(game);
 }
 
 void Mcts::reset(Game& game)
 {
+    Trace::instant("reset", "mcts", long(m_table.size()));
     std::fill(std::begin(m_states), std::end(m_states), StateData{});
     std::fill(std::begin(m_nodes), std::end(m_nodes), nullptr);
     std::fill(std::begin(m_edges), std::end(m_edges), nullptr);
-    TTable.clear();
+    m_table.clear();
+    hh = &m_history[0];
     m_game = game;
+
+    // Only the recycled storage survives the clear
+    edge_capacity = spare_capacity;
+
     reset_counters();
 }
 
@@ -69,67 +109,182 @@ inline double eval_terminal(const Game& game, Color current_player) {
 }
 
 Action Mcts::best_action() {
+    BT_PROFILE_SCOPE(m_profile, search);
+    Trace::Scope trace{ "search", "mcts" };
+
+    // Play a proven win without spending any rollouts
+    if (solver_threshold > 0 && count(~m_game.no_pieces()) <= solver_threshold) {
+        SolverResult result = m_solver.solve();
+        if (result.proof == Proof::win) {
+            ++solved_count;
+            return result.action;
+        }
+    }
+
     setup_root();
 
-    assert(root().key == m_game.key());
+    assert(root().key == node_key());
     assert(current_node() == root());
     assert(!current_node().children.empty());
 
-    Color us = m_game.player_to_move();
-    int iter_counter = 0;
+    Edge* best = nullptr;
 
-    while (iter_counter < n_iterations) {
-        assert(m_game.key() == current_node().key);
-        assert(current_node() == root());
+    if (root_policy == RootPolicy::sequential_halving) {
+        best = sequential_halving();
+    }
+    else {
+        // With a time limit, the clock is only read every few iterations
+        const auto start = std::chrono::steady_clock::now();
+        auto done = [&](int iter_counter) {
+            return time_limit.count() > 0
+                ? iter_counter % 16 == 0 && std::chrono::steady_clock::now() - start >= time_limit
+                : iter_counter >= n_iterations;
+        };
+
+        uint64_t batch_start = Trace::start();
+        for (int iter_counter = 0; !done(iter_counter); ++iter_counter) {
+            run_iteration();
+            if (iter_counter % trace_batch == trace_batch - 1) {
+                Trace::complete("iterations", "mcts", batch_start, trace_batch);
+                batch_start = Trace::start();
+            }
+        }
 
-        // Select the next leaf to be expanded
-        select();
+        best = best_child(current_node(), By::visits);
+    }
 
-        assert(current_node() != root());
+    assert(node_key() == root().key);
+    assert(current_node() == root());
 
-        double reward = 0.5;
+    return oriented(best->action);
+}
 
-        if (current_node().visits == 0) {
-            expand(current_node());
-        }
-        else {
-            assert(is_terminal(current_node()));
-            reward = eval_terminal(m_game, us);
-        }
+/**
+ * Perform one iteration of the search: select a leaf (starting with
+ * @root_edge if it is given), evaluate or expand it and backpropagate
+ * the result.
+ */
+void Mcts::run_iteration(Edge* root_edge) {
+    assert(node_key() == current_node().key);
+    assert(current_node() == root());
+
+    if (root_edge != nullptr) {
+        ++current_node().visits;
+        apply(*root_edge);
+    }
+
+    // Select the next leaf to be expanded
+    select();
 
-        reward = (current_node().children[0].total / (current_node().children[0].visits + 1));
+    assert(current_node() != root());
+
+    double reward = 0.5;
 
-        ++iter_counter;
-        backpropagate(reward);
+    if (m_game.is_lost() || !m_game.pieces(m_game.player_to_move())) {
+        // The game is over: the leaf is never expanded, otherwise the
+        // playouts of its children would go on after the end of the game.
+        // Its edge is scored as a win for the player who just moved.
+        ++current_node().visits;
+        reward = 1.0;
+    }
+    else if (current_node().visits + 1 < expansion_threshold) {
+        // Not reached often enough to be expanded yet: the leaf is
+        // evaluated with a playout and its stats stay on the parent edge
+        ++current_node().visits;
+        reward = sample_leaf();
+    }
+    else {
+        // select() only stops at a node with children when it was never
+        // visited, and pruned nodes are erased, so this is its K-th visit
+        assert(current_node().visits + 1 == expansion_threshold);
+        expand(current_node());
+        current_node().visits = expansion_threshold;
+
+        // The best child is scored for the player to move at the leaf,
+        // the leaf's edge for the player who moved into it
+        reward = 1.0 - current_node().children[0].total / (current_node().children[0].visits + 1);
     }
 
-    assert(m_game.key() == root().key);
-    assert(current_node() == root());
+    backpropagate(reward);
+
+    enforce_budget();
+}
+
+/**
+ * Sequential Halving at the root.
+ *
+ * The iteration budget is split in ceil(log2(n)) rounds. Each round
+ * spreads its share evenly over the remaining root edges, then only
+ * the best half of them (by average value) is kept for the next one.
+ * UCB is still used to select below the root.
+ *
+ * The search never spends more than n_iterations, and stops at the
+ * time limit if there is one, the clock being read every few
+ * iterations as with UCB. The best of the remaining edges is then
+ * returned.
+ */
+Edge* Mcts::sequential_halving() {
+    std::vector<Edge*> candidates;
+    for (auto& e : root().children)
+        candidates.push_back(&e);
+
+    const int n_rounds = std::max(1, int(std::ceil(std::log2(candidates.size()))));
+    const auto start = std::chrono::steady_clock::now();
+    int iter_counter = 0;
+    auto done = [&] {
+        return iter_counter >= n_iterations
+            || (time_limit.count() > 0 && iter_counter % 16 == 0
+                && std::chrono::steady_clock::now() - start >= time_limit);
+    };
+
+    bool stopped = false;
+    while (candidates.size() > 1 && !stopped) {
+        const int per_edge = std::max(1, n_iterations / (n_rounds * int(candidates.size())));
+
+        uint64_t round_start = Trace::start();
+        const int round_first = iter_counter;
+        for (auto it = candidates.begin(); it != candidates.end() && !stopped; ++it) {
+            for (int i = 0; i < per_edge && !(stopped = done()); ++i, ++iter_counter)
+                run_iteration(*it);
+        }
+        Trace::complete("halving round", "mcts", round_start, iter_counter - round_first);
 
-    return best_child(current_node(), By::visits)->action;
+        std::sort(candidates.begin(), candidates.end(), [](const auto* a, const auto* b) {
+            return a->total / (a->visits + 1) > b->total / (b->visits + 1);
+        });
+        candidates.resize((candidates.size() + 1) / 2);
+    }
+
+    return candidates[0];
 }
 
 /**
  * Record the last two actions that were played into the history stack.
+ *
+ * The edges are only recorded if their parent is still in the tree,
+ * it may have been pruned to keep the tree within its memory budget.
  */
 void Mcts::update_history() {
+    auto record = [&](const StateData& parent_sd, Action action) {
+        auto it = m_table.find(key_of(parent_sd));
+        if (it == m_table.end())
+            return;
+        auto& children = it->second.children;
+        auto edge = std::find(children.begin(), children.end(), oriented(action, parent_sd));
+        if (edge != children.end())
+            *hh++ = &*edge;
+    };
+
     Action prev_action = m_game.get_sd()->action;
 
     // If this is not the initial root, track the move history
     if (prev_action != Action::none) {
-        Node* prev = get_node(m_game.get_sd()->prev->key);
-
-        assert(prev->visits > 0);
+        const StateData& prev_sd = *m_game.get_sd()->prev;
+        record(prev_sd, prev_action);
 
-        Edge* edge = &*std::find(prev->children.begin(), prev->children.end(), prev_action);
-        *hh++ = edge;
-
-        prev_action = m_game.get_sd()->prev->action;
-        if (prev_action != Action::none) {
-            prev = get_node(m_game.get_sd()->prev->prev->key);
-            edge = &*std::find(prev->children.begin(), prev->children.end(), prev_action);
-            *hh++ = edge;
-        }
+        prev_action = prev_sd.action;
+        if (prev_action != Action::none)
+            record(*prev_sd.prev, prev_action);
     }
 }
 
@@ -138,7 +293,9 @@ void Mcts::update_history() {
  * at its base and expand populate its children if needed
  */
 void Mcts::setup_root() {
-    m_nodes[0] = get_node(m_game.key());
+    m_nodes[0] = get_node(node_key());
+    // The visits of the new root which were kept from earlier searches
+    Trace::instant("reroot", "mcts", m_nodes[0]->visits);
 
     // Store a copy of the game's StateData at root position
     m_states[0] = *m_game.get_sd();
@@ -177,112 +334,373 @@ Edge* Mcts::best_child(Node& node, By by) {
  * each step. When a leaf is found, return a pointer to it
  */
 void Mcts::select() {
+    BT_PROFILE_SCOPE(m_profile, select);
+
     while (current_node().visits > 0 && !current_node().children.empty()) {
+        BT_PROFILE_RECORD(m_profile, branching, int(current_node().children.size()));
         ++current_node().visits;
         Edge* best = best_child(current_node(), By::ucb);
         apply(*best);
     }
 
+    BT_PROFILE_RECORD(m_profile, selection_depth, int(nn - &m_nodes[1]));
     ++selections_count;
 }
 
 /**
- * Recursively play random actions until the game is lost.
+ * Exact result of the position for its player to move if
+ * it is in the tablebases @tb, Proof::unknown otherwise.
+ */
+inline Proof probe_tablebase(const Tablebase* tb, const Game& game) {
+    return tb && count(~game.no_pieces()) <= tb->max_pieces()
+        ? tb->probe(game).proof
+        : Proof::unknown;
+}
+
+/**
+ * Result of the position for its player to move if a race is
+ * decided for either side (see race()), Proof::unknown otherwise.
+ */
+inline Proof decided_race(const Game& game) {
+    Color us = game.player_to_move();
+    return race(game, us).plies                ? Proof::win
+         : race(game, opposite_of(us)).plies   ? Proof::loss
+         : Proof::unknown;
+}
+
+/**
+ * Exact result of the position for its player to move, from
+ * the tablebases @tb or a decided race, Proof::unknown otherwise.
  */
-template<bool Trace>
-double rollout(Game& game, Action action);
+inline Proof exact_result(const Tablebase* tb, const Game& game) {
+    Proof proof = probe_tablebase(tb, game);
+    return proof != Proof::unknown ? proof : decided_race(game);
+}
 
-template<>
-double rollout<false>(Game& game, Action action) {
+/**
+ * Recursively play random actions drawn with @rng until the game is
+ * lost, printing each position on the way with @Trace.
+ *
+ * Return the reward of the playout for the player to move after
+ * @action, i.e. 0.0 when the player who plays it wins.
+ */
+template<bool Trace, typename Rng>
+double rollout(Game& game, Action action, Rng& rng, const Tablebase* tb, const Nnue::Network* net) {
 
-    StateData sd{};
+    StateData sd;
     game.apply(action, sd);
+#ifdef BT_PROFILE
+    ++rollout_plies;
+#endif
+    if constexpr (Trace)
+        std::cerr << game.view() << std::endl;
 
     // Report a win if game is lost after playing the action.
     // The score reported is weighted down by the game ply.
     // We put a big weight so that we don't return score
     // valued at less than 0.5 on a winning line.
-    if (game.is_lost()) {
+    // Capturing the last piece of the opponent wins too,
+    // and leaves it without any action to draw from.
+    if (game.is_lost() || !game.pieces(game.player_to_move())) {
         game.undo(action);
+        if constexpr (Trace)
+            std::cerr << (game.player_to_move() == Color::white ? "WHITE" : "BLACK")
+                << " wins, returning "
+                << eval_terminal(game, game.player_to_move())
+                << std::endl;
         return eval_terminal(game, game.player_to_move());
     }
 
+    // Stop at the exact result when the endgame is in the tablebases
+    // or a race is decided, which is already from the point of view
+    // of the player to move
+    if (Proof proof = exact_result(tb, game); proof != Proof::unknown) {
+        game.undo(action);
+        if constexpr (Trace)
+            std::cerr << "Exact result, returning " << (proof == Proof::win ? 1.0 : 0.0) << std::endl;
+        return proof == Proof::win ? 1.0 : 0.0;
+    }
+
+    // Or at the network's estimate instead of playing on, which is
+    // also for the player to move
+    if (net) {
+        double value = net->evaluate(game);
+        game.undo(action);
+        if constexpr (Trace)
+            std::cerr << "Network estimate, returning " << value << std::endl;
+        return value;
+    }
+
     // Pick a random action
     game.compute_valid_actions(rollout_buffer);
-    Action a = random_choice(rollout_buffer);
+    Action a = random_choice(rollout_buffer, rng);
 
     // Swap reward value of a win
     // between 0.0 and 1.0 at each ply
-    double reward = 1.0 - rollout<false>(game, a);
+    double reward = 1.0 - rollout<Trace>(game, a, rng, tb, net);
 
     game.undo(action);
     return reward;
 }
 
-template<>
-double rollout<true>(Game& game, Action action) {
+/**
+ * Sample an action by performing @count rollouts starting with
+ * the given @edge.action.
+ */
+double Mcts::sample(Action action, int count, bool trace) {
+    BT_PROFILE_SCOPE(m_profile, sample);
 
-    StateData sd{};
-    game.apply(action, sd);
-    std::cerr << game.view() << std::endl;
+    // The network's estimate is deterministic, one is enough
+    const int n_samples = m_network ? 1 : count;
+    double ret = 0.0;
+    for (int i=0; i<n_samples; ++i) {
+#ifdef BT_PROFILE
+        rollout_plies = 0;
+#endif
+        double score = trace ? rollout<true>(m_game, action, m_rng, m_tablebase, m_network)
+                     : rollout<false>(m_game, action, m_rng, m_tablebase, m_network);
+        BT_PROFILE_RECORD(m_profile, rollout_length, rollout_plies);
+        ret += score;
+    }
+    ++rollouts_count;
+    return ret * count / n_samples;
+}
 
-    if (game.is_lost()) {
-        game.undo(action);
-        std::cerr << (game.player_to_move() == Color::white ? "WHITE" : "BLACK")
-            << " wins, returning "
-            << eval_terminal(game, game.player_to_move())
-            << std::endl;
-        return eval_terminal(game, game.player_to_move());
+/**
+ * Evaluate the current (unexpanded) leaf for the player who moved into
+ * it, as the rewards backed up to its parent edge, by sampling a random
+ * action from its position, with the network if there is one, or exactly
+ * if it is in the tablebases or a race is decided.
+ */
+double Mcts::sample_leaf() {
+    if (m_game.is_lost() || !m_game.pieces(m_game.player_to_move()))
+        return 1.0;
+
+    // The exact results and the network are for the player to move at the leaf
+    if (Proof proof = probe_tablebase(m_tablebase, m_game); proof != Proof::unknown) {
+        ++tb_hits_count;
+        return proof == Proof::loss ? 1.0 : 0.0;
     }
 
-    game.compute_valid_actions(rollout_buffer);
-    Action a = random_choice(rollout_buffer);
+    if (Proof proof = decided_race(m_game); proof != Proof::unknown) {
+        ++races_count;
+        return proof == Proof::loss ? 1.0 : 0.0;
+    }
 
-    double reward = 1.0 - rollout<true>(game, a);
+    if (m_network) {
+        ++network_count;
+        return 1.0 - m_network->evaluate(m_game);
+    }
 
-    game.undo(action);
-    return reward;
+    m_game.compute_valid_actions(m_actions_buffer);
+    Action action = random_choice(m_actions_buffer, m_rng);
+
+    return sample(action, n_initial_samples) / n_initial_samples;
 }
 
 /**
- * Sample an action by performing @count rollouts starting with
- * the given @edge.action.
+ * Heuristic value of playing @action for the player to move, used as
+ * the initial implicit minimax value of its edge: exact when the game
+ * ends or the result is known, the network's or the static evaluation
+ * of the resulting position otherwise.
  */
-double Mcts::sample(Action action, int count, bool trace) {
-    double ret = 0.0;
-    for (int i=0; i<count; ++i) {
-        double score = trace ? rollout<true>(m_game, action)
-                     : rollout<false>(m_game, action);
-        ret += score;
+double Mcts::evaluate_child(Action action) {
+    StateData st;
+    m_game.apply(action, st);
+
+    double value = 1.0;
+    if (!m_game.is_lost() && m_game.pieces(m_game.player_to_move())) {
+        Proof proof = exact_result(m_tablebase, m_game);
+        value = proof != Proof::unknown ? (proof == Proof::loss ? 1.0 : 0.0)
+              : m_network ? 1.0 - m_network->evaluate(m_game)
+              : 1.0 - static_eval(m_game);
     }
-    ++rollouts_count;
-    return ret;
+
+    m_game.undo(action);
+    return value;
+}
+
+/**
+ * evaluate_child() of every action of m_actions_buffer, into
+ * m_child_values. The children left to the static evaluation are
+ * evaluated together with static_eval_batch().
+ */
+void Mcts::evaluate_children() {
+    const size_t n_actions = m_actions_buffer.size();
+    m_child_values.assign(n_actions, 1.0);
+    m_batch.clear();
+
+    for (size_t i = 0; i < n_actions; ++i) {
+        Action a = m_actions_buffer[i];
+        StateData st;
+        m_game.apply(a, st);
+
+        if (!m_game.is_lost() && m_game.pieces(m_game.player_to_move())) {
+            if (Proof proof = exact_result(m_tablebase, m_game); proof != Proof::unknown)
+                m_child_values[i] = proof == Proof::loss ? 1.0 : 0.0;
+            else if (m_network)
+                m_child_values[i] = 1.0 - m_network->evaluate(m_game);
+            else
+                m_batch.push(i, m_game.pieces(Color::white), m_game.pieces(Color::black), m_game.player_to_move());
+        }
+
+        m_game.undo(a);
+    }
+
+    m_batch.evaluate();
+    for (size_t k = 0; k < m_batch.size(); ++k)
+        m_child_values[m_batch.index[k]] = 1.0 - m_batch.values[k];
 }
 
 /**
  * Populate @node's children from @m_game's valid_actions()
  *
+ * The edges are stored in the orientation of @node, see oriented().
+ * Each edge starts with the average of n_initial_samples playouts, or
+ * of the playouts spread over the edges by adaptive_sample() when
+ * adaptive samples are enabled, scored like its minimax value for the
+ * player who takes it.
+ *
  * @Remark  We reuse the actions_buffer while sampling
  * so do not sample before entering every children!
  */
 void Mcts::expand(Node& node) {
+    BT_PROFILE_SCOPE(m_profile, expand);
+    Trace::Scope trace{ "expand", "mcts" };
+
     m_game.compute_valid_actions(m_actions_buffer);
 
-    std::transform(
-        m_actions_buffer.begin(),
-        m_actions_buffer.end(),
-        std::back_inserter(node.children),
-        [&](Action a){ return Edge{ a, sample(a, n_initial_samples) / n_initial_samples }; });
+    // Reuse the storage of a pruned node if there is one
+    if (node.children.capacity() == 0 && !m_spare_children.empty()) {
+        node.children = std::move(m_spare_children.back());
+        m_spare_children.pop_back();
+        spare_capacity -= node.children.capacity();
+    }
+    size_t capacity = node.children.capacity();
+
+    const size_t n_actions = m_actions_buffer.size();
+    m_initial_values.resize(n_actions);
+
+    if (adaptive_samples && !m_network && n_initial_samples > 1) {
+        m_sample_stats.assign(n_actions, SampleStats{});
+        expansion_playouts += adaptive_sample(m_sample_stats, n_initial_samples * int(n_actions),
+                                              [&](size_t i) { return 1.0 - sample(m_actions_buffer[i]); });
+        for (size_t i = 0; i < n_actions; ++i)
+            m_initial_values[i] = m_sample_stats[i].mean();
+    }
+    else {
+        for (size_t i = 0; i < n_actions; ++i)
+            m_initial_values[i] = 1.0 - sample(m_actions_buffer[i], n_initial_samples) / n_initial_samples;
+        expansion_playouts += (m_network ? 1 : n_initial_samples) * long(n_actions);
+    }
+
+    if (minimax_weight > 0.0)
+        evaluate_children();
+    for (size_t i = 0; i < n_actions; ++i) {
+        Action a = m_actions_buffer[i];
+        node.children.push_back(minimax_weight > 0.0
+            ? Edge{ oriented(a), m_initial_values[i], m_child_values[i] }
+            : Edge{ oriented(a), m_initial_values[i] });
+    }
 
     std::sort(
         node.children.begin(),
         node.children.end(),
         [](const auto& a, const auto& b){ return a.total > b.total; });
 
+    edge_capacity += node.children.capacity() - capacity;
     node.visits = 1;
     ++expansions_count;
 }
 
+/**
+ * Approximate number of bytes used by the tree.
+ */
+size_t Mcts::tree_memory() const {
+    return m_table.size() * node_footprint + edge_capacity * sizeof(Edge);
+}
+
+/**
+ * Record the memory high-water mark and prune the tree
+ * down to 3/4 of the budget when it is exceeded.
+ */
+void Mcts::enforce_budget() {
+    size_t memory = tree_memory();
+    memory_high_water = std::max(memory_high_water, memory);
+
+    if (memory_budget > 0 && memory > memory_budget)
+        prune(3 * memory_budget / 4);
+}
+
+/**
+ * Insert the keys of all nodes reachable from @node
+ * through visited edges in @reachable.
+ */
+void Mcts::mark_reachable(Node& node, std::unordered_set<Key>& reachable) {
+    for (auto& e : node.children) {
+        if (e.visits == 0)
+            continue;
+
+        Key key = child_key(e);
+        if (!m_table.count(key) || !reachable.insert(key).second)
+            continue;
+
+        apply(e);
+        mark_reachable(current_node(), reachable);
+        undo();
+    }
+}
+
+/**
+ * Shrink the tree until it uses less than @target bytes.
+ *
+ * Nodes which cannot be reached from the root anymore (e.g. the
+ * siblings of previously played actions) are dropped first, then
+ * the least visited ones, so leaves go before their subtrees.
+ * The statistics of the parent edges are kept: a pruned node is
+ * simply expanded again if the search comes back to it, reusing
+ * the storage recycled here.
+ */
+void Mcts::prune(size_t target) {
+    assert(current_node() == root());
+    Trace::Scope trace{ "prune", "gc" };
+    const int pruned_before = pruned_count;
+
+    std::unordered_set<Key> reachable{ root().key };
+    mark_reachable(root(), reachable);
+
+    std::vector<std::pair<int, Key>> candidates;
+    candidates.reserve(m_table.size());
+    for (const auto& [key, node] : m_table) {
+        if (key != root().key)
+            candidates.emplace_back(reachable.count(key) ? node.visits : -1, key);
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    for (auto [visits, key] : candidates) {
+        if (visits >= 0 && tree_memory() <= target)
+            break;
+
+        auto it = m_table.find(key);
+        auto& children = it->second.children;
+
+        // Keep at most an eighth of the budget aside for the next expansions
+        if ((spare_capacity + children.capacity()) * sizeof(Edge) <= memory_budget / 8) {
+            spare_capacity += children.capacity();
+            children.clear();
+            m_spare_children.push_back(std::move(children));
+        }
+        else {
+            edge_capacity -= children.capacity();
+        }
+        m_table.erase(it);
+        ++pruned_count;
+    }
+
+    ++prunes_count;
+    trace.set_arg(pruned_count - pruned_before);
+}
+
 void update_stats(Edge& edge, double reward) {
     edge.total += reward;
     ++edge.visits;
@@ -291,14 +709,36 @@ void update_stats(Edge& edge, double reward) {
 /**
  * Update the stats of every nodes on the
  * current branch after sampling a leaf.
+ *
+ * With a minimax weight, the implicit minimax values are backed up
+ * along the same branch: each edge takes the negamax of the edges
+ * of its child, which were evaluated when the child was expanded.
  */
 void Mcts::backpropagate(double reward) {
+    BT_PROFILE_SCOPE(m_profile, backpropagate);
+
     assert(current_node() != root());
 
     while (current_node() != root()) {
         // Add the current reward to the previous edge's average
         update_stats(previous_edge(), reward);
 
+        // Also aggregate it on the node itself so that every
+        // incoming edge of a transposition shares its value
+        if (transposition_stats) {
+            current_node().total += reward;
+            ++current_node().updates;
+        }
+
+        // Back the minimax value of the node up to its incoming edge,
+        // the values of its own edges being up to date already
+        if (minimax_weight > 0.0 && !current_node().children.empty()) {
+            float best = std::numeric_limits<float>::lowest();
+            for (const auto& e : current_node().children)
+                best = std::max(best, e.minimax);
+            previous_edge().minimax = 1.0f - best;
+        }
+
         // Swap the reward from win to loss and vice versa
         reward = 1.0 - reward;
 
@@ -306,15 +746,30 @@ void Mcts::backpropagate(double reward) {
         undo();
     }
 
-    assert(m_game.key() == current_node().key);
+    assert(node_key() == current_node().key);
 }
 
 /**
  * Compute the Upper Confidence Bound for the regret
  * associated to selecting @child next.
+ *
+ * With transposition statistics, the exploitation term is read from
+ * the child node (when it has been backed up through at least once)
+ * so that all move orders leading to it share the same estimate.
+ * The exploration term stays on the edge.
+ *
+ * With a minimax weight, the exploitation term is blended with the
+ * implicit minimax value of the edge (see backpropagate()).
  */
 double Mcts::UCB(const Node& parent, const Edge& child) {
     double ret = (child.total) / (1.0 + child.visits);
+    if (transposition_stats) {
+        auto it = m_table.find(child_key(child));
+        if (it != m_table.end() && it->second.updates > 0)
+            ret = it->second.total / it->second.updates;
+    }
+    if (minimax_weight > 0.0)
+        ret = (1.0 - minimax_weight) * ret + minimax_weight * child.minimax;
     ret += exp_cst * std::sqrt(std::log(parent.visits) / (child.visits + 1.0));
     return ret;
 }
@@ -330,11 +785,11 @@ void Mcts::apply(Edge& edge) {
 
     // Apply it to the game, using @m_states[ply]
     // as the StateData object
-    m_game.apply(edge.action, *sd++);
+    m_game.apply(oriented(edge.action), *sd++);
 
     // Locate/instantiate resulting state in
     // the tree and push it on the node stack
-    *nn++ = get_node(m_game.key());
+    *nn++ = get_node(node_key());
 }
 
 /**
@@ -348,8 +803,9 @@ void Mcts::undo() {
     // Pop the edge stack
     --ee;
 
-    // Undo the action
-    m_game.undo((*ee)->action);
+    // Undo the action (as it was played in @m_game,
+    // which may be the reflection of the edge's action)
+    m_game.undo(m_game.get_sd()->action);
 
     // Pop the nodes stack
     --nn;
@@ -383,7 +839,7 @@ void Mcts::recurse_graphviz(std::ostream& out, Node& node, int& n_nodes, std::ma
         if (!_id) {
             out << std::to_string(_id = ++n_nodes)
                 << " [label=\"" << e << "\""
-                << " xlabel=\"" << m_game.view(e.action) << "\"]\n";
+                << " xlabel=\"" << m_game.view(m_game.get_sd()->action) << "\"]\n";
         }
 
         // Generate the link in any case
@@ -419,7 +875,7 @@ void Mcts::recurse_json_tree(std::ostream& out, Node& node, int ply, int& node_c
 
         out << R"("id": )"     << std::to_string(_id = ++node_count) << ", "
             << R"("name": ")"  << e << R"(", )"
-            << R"("str": ")"   << m_game.view(e.action, true) << R"(", )"
+            << R"("str": ")"   << m_game.view(m_game.get_sd()->action, true) << R"(", )"
             << R"("total": )"  << e.total << ", "
             << R"("visits": )" << e.visits << ", "
             << R"("ply": )"    << ply << ", "
@@ -438,7 +894,7 @@ void Mcts::recurse_json_tree(std::ostream& out, Node& node, int ply, int& node_c
 }
 
 void Mcts::write_json_tree(std::ostream& out) {
-    assert(m_game.key() == current_node().key);
+    assert(node_key() == current_node().key);
     assert(current_node() == root());
 
     static int node_count = 0;
@@ -467,7 +923,7 @@ void Mcts::write_json_tree(std::ostream& out) {
 }
 
 void Mcts::write_graphviz(std::ostream& out, int n_nodes_max) {
-    assert(m_game.key() == current_node().key);
+    assert(node_key() == current_node().key);
     assert(current_node() == root());
 
     int n_nodes = 0;
@@ -488,14 +944,69 @@ void Mcts::print_counters(std::ostream& out) const {
     out << "Selections: " << selections_count << '\n'
         << "Expansions: " << expansions_count << '\n'
         << "Rollouts: "   << rollouts_count << '\n'
-        << "Total number of nodes: " << TTable.size() << '\n'
-        << std::endl;
+        << "Total number of nodes: " << m_table.size() << '\n'
+        << "Tree memory: " << tree_memory() / 1024 << "KB"
+        << " (high-water mark: " << memory_high_water / 1024 << "KB)\n"
+        << "Prunes: " << prunes_count << " (" << pruned_count << " nodes recycled)\n"
+        << "Solved positions: " << solved_count << '\n'
+        << "Tablebase leaves: " << tb_hits_count << '\n'
+        << "Decided races: " << races_count << '\n'
+        << "Network leaves: " << network_count << '\n'
+        << "Playouts per expansion: " << (expansions_count ? double(expansion_playouts) / expansions_count : 0.0) << '\n';
+#ifdef BT_PROFILE
+    out << '\n';
+    print_profile(out);
+#endif
+    out << std::endl;
 }
 
 void Mcts::reset_counters() {
     selections_count = 0;
     expansions_count = 0;
     rollouts_count = 0;
+    prunes_count = 0;
+    pruned_count = 0;
+    memory_high_water = 0;
+    solved_count = 0;
+    tb_hits_count = 0;
+    races_count = 0;
+    network_count = 0;
+    expansion_playouts = 0;
+#ifdef BT_PROFILE
+    m_profile.reset();
+#endif
+}
+
+#ifdef BT_PROFILE
+/**
+ * Profile of the searches since the counters were reset, with the
+ * shape of the current tree.
+ */
+Profile::Counters Mcts::profile() const {
+    Profile::Counters ret = m_profile;
+    for (const auto& [key, node] : m_table)
+        ret.record(Profile::children, int(node.children.size()));
+    return ret;
+}
+#endif
+
+void Mcts::print_profile(std::ostream& out) const {
+#ifdef BT_PROFILE
+    profile().print(out);
+#else
+    out << "Profiling is disabled, build with -DBT_PROFILE=ON\n";
+#endif
+}
+
+/**
+ * Write the profile as JSON, or null if profiling is disabled.
+ */
+void Mcts::write_profile_json(std::ostream& out) const {
+#ifdef BT_PROFILE
+    profile().write_json(out);
+#else
+    out << "null";
+#endif
 }
 
 void Mcts::print_root_actions(std::ostream& out) {
@@ -503,3 +1014,33 @@ void Mcts::print_root_actions(std::ostream& out) {
         out << e << std::endl;
     }
 }
+
+/**
+ * Fill @out with the actions of the game's position and their visit
+ * counts, left empty if the position is not in the tree (when the
+ * solver answered without searching).
+ */
+void Mcts::root_visits(std::vector<std::pair<Action, int>>& out) const {
+    out.clear();
+    auto it = m_table.find(node_key());
+    if (it == m_table.end())
+        return;
+    for (const Edge& e : it->second.children)
+        out.emplace_back(oriented(e.action), e.visits);
+}
+
+/**
+ * Visits and average reward of the root edge of @a for the player
+ * to move, its initial value counting as one of the rewards as in
+ * UCB() and By::avg, { 0, 0.0 } if the position is not in the tree
+ * or the edge was not visited.
+ */
+std::pair<int, double> Mcts::root_stats(Action a) const {
+    auto it = m_table.find(node_key());
+    if (it == m_table.end())
+        return { 0, 0.0 };
+    for (const Edge& e : it->second.children)
+        if (oriented(e.action) == a && e.visits > 0)
+            return { e.visits, e.total / (e.visits + 1) };
+    return { 0, 0.0 };
+}
@@ -3,31 +3,54 @@
 
 #include "types.h"
 #include "game.h"
-
+#include "eval.h"
+#include "nnue.h"
+#include "profile.h"
+#include "random.h"
+#include "sampler.h"
+#include "solver.h"
+#include "tablebase.h"
+
+#include <algorithm>
+#include <chrono>
 #include <iosfwd>
 #include <string_view>
+#include <utility>
 #include <vector>
 #include <map>
 #include <unordered_map>
+#include <unordered_set>
 
 
 struct Edge {
     Edge() = default;
     explicit Edge(Action a)
-        : action{a}, visits{0}, total{0.0} {}
+        : action{a}, visits{0}, total{0.0}, minimax{0.5f} {}
     Edge(Action a, double t)
-        : action{a}, visits{0}, total{t} {}
+        : action{a}, visits{0}, total{t}, minimax{float(t)} {}
+    Edge(Action a, double t, double m)
+        : action{a}, visits{0}, total{t}, minimax{float(m)} {}
     Action action;
     int visits;
+    // Sum of the rewards of the edge for the player who takes it, the
+    // initial value of the edge counting as one of them
     double total;
+    // Implicit minimax value of the edge for the player who takes it:
+    // the heuristic evaluation of the child when it is a leaf, backed
+    // up from the child's own edges once it has been expanded.
+    float minimax;
     bool operator==(Action a) { return action == a; }
 };
 
 struct Node {
     Node() = default;
-    Node(Key k, int v) : key{k}, visits{v} {}
+    Node(Key k, int v) : key{k}, visits{v}, updates{0}, total{0.0} {}
     Key key;
     int visits;
+    // Value statistics gathered through every incoming edge,
+    // only maintained when transposition statistics are enabled.
+    int updates;
+    double total;
     std::vector<Edge> children;
     bool operator==(const Node& other) const { return key == other.key; }
 };
@@ -36,8 +59,16 @@ enum class By {
     visits, ucb, avg
 };
 
+/// How the iterations are spread over the root's children
+enum class RootPolicy {
+    ucb, sequential_halving
+};
+
 class Mcts {
 public:
+    // Generator of the playouts, which may be any uniform random bit generator
+    using Rng = Random::Rng;
+
     Mcts(Game& game);
     double sample(Action action, int count=1, bool trace=false);
     Action best_action();
@@ -45,23 +76,57 @@ public:
     void update_history();
 
     void set_n_iterations(int n);
+    void set_time_limit(int ms);
     void set_exp_cst(double c);
     void set_n_init_samples(int n);
+    void set_transposition_stats(bool b);
+    void set_symmetry(bool b);
+    void set_memory_budget(size_t mb);
+    void set_expansion_threshold(int k);
+    void set_root_policy(RootPolicy p);
+    void set_solver_threshold(int n_pieces);
+    void set_tablebase(const Tablebase* tb);
+    void set_network(const Nnue::Network* net);
+    void set_minimax_weight(double w);
+    void set_adaptive_samples(bool b);
+    void set_rng(const Rng& rng);
+    int n_rollouts() const { return rollouts_count; }
+    int n_selections() const { return selections_count; }
+    size_t n_nodes() const { return m_table.size(); }
+    size_t peak_memory() const { return memory_high_water; }
+    size_t tree_memory() const;
     void write_graphviz(std::ostream&, int n_nodes_max=-1);
     void write_json_tree(std::ostream&);
     void print_counters(std::ostream&) const;
+    void print_profile(std::ostream&) const;
+    void write_profile_json(std::ostream&) const;
     void print_root_actions(std::ostream&);
+    void root_visits(std::vector<std::pair<Action, int>>& out) const;
+    std::pair<int, double> root_stats(Action a) const;
     void reset_counters();
 
 protected:
     void setup_root();
     Edge* best_child(Node& parent, By by);
     void select();
+    void run_iteration(Edge* root_edge = nullptr);
+    Edge* sequential_halving();
     void expand(Node& node);
+    double sample_leaf();
+    double evaluate_child(Action action);
+    void evaluate_children();
     double UCB(const Node& parent, const Edge& child);
     void backpropagate(double reward);
+    void enforce_budget();
+    void prune(size_t target);
+    void mark_reachable(Node& node, std::unordered_set<Key>& reachable);
 
     Node* get_node(Key key);
+    Key node_key() const;
+    Key child_key(const Edge& edge) const;
+    Key key_of(const StateData&) const;
+    Action oriented(Action a) const;
+    Action oriented(Action a, const StateData&) const;
     Node& root();
     Node& current_node();
     Edge& previous_edge();
@@ -79,26 +144,93 @@ private:
     Node* m_nodes[max_depth], **nn = &m_nodes[0];
     Edge* m_edges[max_depth], **ee = &m_edges[0];
     std::vector<Action> m_actions_buffer;
+    Rng m_rng;
     Edge* m_history[max_depth], **hh = &m_history[0];
 
+    // Transposition table holding the nodes of the tree
+    std::unordered_map<Key, Node> m_table;
+
     double exp_cst = 1.4;
     int n_initial_samples = 1;
     int n_iterations = 500;
+    // Search for that long instead of n_iterations if it is not 0,
+    // or at most for that long with sequential halving, whose rounds
+    // are still sized from n_iterations
+    std::chrono::milliseconds time_limit{ 0 };
+    int expansion_threshold = 1;
+    RootPolicy root_policy = RootPolicy::ucb;
+    bool transposition_stats = false;
+    bool symmetry = false;
+    size_t memory_budget = 0;
+
+    // Spread the initial samples of the new edges with adaptive_sample()
+    // instead of giving n_initial_samples to each of them
+    bool adaptive_samples = false;
+    std::vector<SampleStats> m_sample_stats;
+    std::vector<double> m_initial_values;
+
+    // Positions with at most that many pieces are first given to the solver
+    Solver m_solver;
+    int solver_threshold = 0;
+
+    // Exact results of small endgames, used instead of playouts
+    const Tablebase* m_tablebase = nullptr;
+
+    // Evaluates the leaves and the new edges instead of the playouts
+    const Nnue::Network* m_network = nullptr;
+
+    // Weight of the implicit minimax values in the exploitation
+    // term of UCB, 0 to only use the rollout averages
+    double minimax_weight = 0.0;
+    std::vector<double> m_child_values;
+    EvalBatch m_batch;
+
+    // Children vectors of pruned nodes, recycled by expand()
+    std::vector<std::vector<Edge>> m_spare_children;
+    size_t spare_capacity = 0;
+    size_t edge_capacity = 0;
 
     int rollouts_count = 0;
     int expansions_count = 0;
     int selections_count = 0;
+    int prunes_count = 0;
+    int pruned_count = 0;
+    size_t memory_high_water = 0;
+    int solved_count = 0;
+    int tb_hits_count = 0;
+    int races_count = 0;
+    int network_count = 0;
+    long expansion_playouts = 0;
+
+#ifdef BT_PROFILE
+    // Cycles spent in each phase and shape of the searches
+    Profile::Counters m_profile;
+    Profile::Counters profile() const;
+#endif
 };
 
-extern std::unordered_map<Key, Node> TTable;
-
 inline bool Mcts::is_terminal(const Node& node) const { return node.children.empty() && node.visits > 0; }
 inline Node& Mcts::root() { return *m_nodes[0]; }
 inline Node& Mcts::current_node() { return **(nn - 1); }
 inline Edge& Mcts::previous_edge() { return **(ee - 1); }
 inline void Mcts::set_n_iterations(int n) { n_iterations = n; }
+inline void Mcts::set_time_limit(int ms) { time_limit = std::chrono::milliseconds(ms); }
 inline void Mcts::set_exp_cst(double c) { exp_cst = c; }
 inline void Mcts::set_n_init_samples(int n) { n_initial_samples = n; }
+inline void Mcts::set_transposition_stats(bool b) { transposition_stats = b; }
+inline void Mcts::set_symmetry(bool b) { symmetry = b; }
+inline void Mcts::set_memory_budget(size_t mb) { memory_budget = mb << 20; }
+inline void Mcts::set_expansion_threshold(int k) { expansion_threshold = std::max(k, 1); }
+inline void Mcts::set_root_policy(RootPolicy p) { root_policy = p; }
+inline void Mcts::set_solver_threshold(int n_pieces) { solver_threshold = n_pieces; }
+inline void Mcts::set_tablebase(const Tablebase* tb) { m_tablebase = tb; }
+inline void Mcts::set_network(const Nnue::Network* net) { m_network = net; }
+inline void Mcts::set_minimax_weight(double w) { minimax_weight = std::clamp(w, 0.0, 1.0); }
+inline void Mcts::set_adaptive_samples(bool b) { adaptive_samples = b; }
+inline void Mcts::set_rng(const Rng& rng) { m_rng = rng; }
+inline Key Mcts::key_of(const StateData& st) const { return symmetry ? std::min(st.key, st.mirror_key) : st.key; }
+inline Key Mcts::node_key() const { return key_of(*m_game.get_sd()); }
+inline Action Mcts::oriented(Action a) const { return oriented(a, *m_game.get_sd()); }
 
 
 #endif // MCTS_H_
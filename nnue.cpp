@@ -0,0 +1,220 @@
+#include "nnue.h"
+#include "types.h"
+#include "bitboard.h"
+#include "game.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+
+// Compile the inner loops for AVX2 as well, selected when the program is loaded
+#if defined(__x86_64__) && defined(__ELF__)
+#define SIMD_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define SIMD_CLONES
+#endif
+
+namespace Nnue {
+
+namespace {
+
+    constexpr uint32_t magic = 0x4E4E5442;  // "BTNN"
+    constexpr uint32_t version = 1;
+
+    /**
+     * Input of the piece of color @c on @sq seen from @perspective.
+     */
+    inline int feature(Color perspective, Color c, Square sq) {
+        return (c == perspective ? 0 : Nsquares) + to_integral(relative(perspective, sq));
+    }
+
+    SIMD_CLONES
+    void add_row(int16_t* acc, const int16_t* row) {
+        for (int i = 0; i < n_hidden; ++i)
+            acc[i] += row[i];
+    }
+
+    SIMD_CLONES
+    void sub_row(int16_t* acc, const int16_t* row) {
+        for (int i = 0; i < n_hidden; ++i)
+            acc[i] -= row[i];
+    }
+
+    /**
+     * Set @acc to @prev after moving a piece, whose inputs
+     * go from the row @from to the row @to.
+     */
+    SIMD_CLONES
+    void move_row(int16_t* acc, const int16_t* prev, const int16_t* from, const int16_t* to) {
+        for (int i = 0; i < n_hidden; ++i)
+            acc[i] = prev[i] - from[i] + to[i];
+    }
+
+    /**
+     * Output of the last two layers given the accumulators
+     * @us and @them of the player to move and its opponent.
+     */
+    SIMD_CLONES
+    int propagate(const int16_t* us, const int16_t* them,
+                  const int32_t* biases2, const int8_t (*weights2)[2 * n_hidden],
+                  int32_t bias3, const int8_t* weights3) {
+        alignas(32) uint8_t input[2 * n_hidden];
+        for (int i = 0; i < n_hidden; ++i) {
+            input[i] = std::clamp<int16_t>(us[i], 0, activation_scale);
+            input[n_hidden + i] = std::clamp<int16_t>(them[i], 0, activation_scale);
+        }
+
+        int32_t out = bias3;
+        for (int j = 0; j < n_l2; ++j) {
+            int32_t sum = biases2[j];
+            for (int i = 0; i < 2 * n_hidden; ++i)
+                sum += weights2[j][i] * input[i];
+            out += weights3[j] * std::clamp(sum >> weight_scale_bits, 0, activation_scale);
+        }
+        return out;
+    }
+
+    template<typename T, size_t N>
+    bool read(std::istream& is, T (&values)[N]) {
+        return bool(is.read(reinterpret_cast<char*>(values), sizeof(values)));
+    }
+
+    std::atomic<uint64_t> next_id{ 1 };
+
+    /// Accumulator of the position of @key for the weights @id
+    struct Entry {
+        uint64_t id;
+        Key key;
+        Accumulator acc;
+    };
+
+    /**
+     * Accumulators of the positions last evaluated, and of the positions
+     * on the way to them, by ply, one stack per thread. An entry holds
+     * for any state of the same key, the accumulator only depending on
+     * the position.
+     */
+    thread_local Entry accumulator_stack[max_depth];
+
+    inline Entry& entry(int ply) {
+        return accumulator_stack[ply % max_depth];
+    }
+
+}  // namespace
+
+
+/**
+ * Load the weights from the file @fp, see Network for its layout.
+ */
+bool Network::load(const std::filesystem::path& fp) {
+    std::ifstream ifs{ fp, std::ios::binary };
+    uint32_t header[5];
+
+    if (!ifs || !read(ifs, header)
+        || header[0] != magic || header[1] != version
+        || header[2] != n_inputs || header[3] != n_hidden || header[4] != n_l2) {
+        std::cerr << "Invalid network " << fp << std::endl;
+        return false;
+    }
+
+    int32_t bias[1];
+    bool ok = read(ifs, biases1) && read(ifs, weights1)
+        && read(ifs, biases2) && read(ifs, weights2)
+        && read(ifs, bias) && read(ifs, weights3)
+        && ifs.peek() == std::ifstream::traits_type::eof();
+
+    if (!ok) {
+        std::cerr << "Invalid network " << fp << std::endl;
+        return false;
+    }
+    bias3 = bias[0];
+    m_id = next_id++;
+    return true;
+}
+
+/**
+ * Compute @acc from scratch for the position of @game.
+ */
+void Network::refresh(const Game& game, Accumulator& acc) const {
+    for (Color p : { Color::white, Color::black }) {
+        int16_t* values = acc.values[to_integral(p)];
+        std::copy(std::begin(biases1), std::end(biases1), values);
+
+        for (Color c : { Color::white, Color::black }) {
+            Bitboard pcs = game.pieces(c);
+            while (pcs)
+                add_row(values, weights1[feature(p, c, pop_lsb(pcs))]);
+        }
+    }
+}
+
+/**
+ * Bring the accumulator of @game's current state up to date, by
+ * replaying the moves played since the last state whose accumulator
+ * is on the stack, or from scratch when that is cheaper.
+ */
+const Accumulator& Network::update(Game& game) const {
+    StateData* path[max_depth];
+    int n = 0;
+    const int n_pieces = count(~game.no_pieces());
+    const int ply = game.ply();
+
+    for (StateData* st = game.get_sd(); entry(ply - n).id != m_id || entry(ply - n).key != st->key; st = st->prev) {
+        if (!st->prev || ply == n || 3 * (n + 1) > n_pieces) {
+            Entry& e = entry(ply);
+            refresh(game, e.acc);
+            e.id = m_id;
+            e.key = game.key();
+            return e.acc;
+        }
+        path[n++] = st;
+    }
+
+    for (int k = n - 1; k >= 0; --k) {
+        const StateData& st = *path[k];
+        const Accumulator& prev = entry(ply - k - 1).acc;
+        Entry& e = entry(ply - k);
+        Square from = from_square(st.action);
+        Square to = to_square(st.action);
+
+        // The last move, path[0], was played by the opponent of the player to move
+        Color mover = k % 2 ? game.player_to_move() : opposite_of(game.player_to_move());
+
+        for (Color p : { Color::white, Color::black }) {
+            int16_t* values = e.acc.values[to_integral(p)];
+            move_row(values, prev.values[to_integral(p)],
+                     weights1[feature(p, mover, from)], weights1[feature(p, mover, to)]);
+            if (st.capture)
+                sub_row(values, weights1[feature(p, opposite_of(mover), to)]);
+        }
+        e.id = m_id;
+        e.key = st.key;
+    }
+    return entry(ply).acc;
+}
+
+/**
+ * Output of the network for @game's player to move, as a
+ * logit scaled by 127 * 64.
+ */
+int Network::evaluate_logit(Game& game) const {
+    const Accumulator& acc = update(game);
+    Color us = game.player_to_move();
+
+    return propagate(acc.values[to_integral(us)], acc.values[to_integral(opposite_of(us))],
+                     biases2, weights2, bias3, weights3);
+}
+
+/**
+ * Estimated probability that @game's player to move wins.
+ */
+double Network::evaluate(Game& game) const {
+    constexpr double scale = activation_scale << weight_scale_bits;
+    return 1.0 / (1.0 + std::exp(-evaluate_logit(game) / scale));
+}
+
+}  // namespace Nnue
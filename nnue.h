@@ -0,0 +1,78 @@
+#ifndef NNUE_H_
+#define NNUE_H_
+
+#include "types.h"
+
+#include <cstdint>
+#include <filesystem>
+
+
+class Game;
+
+namespace Nnue {
+
+/// One input per (color, square), from the point of view of each side:
+/// its own pieces first, with the squares flipped vertically for black.
+constexpr int n_inputs = 2 * Nsquares;
+constexpr int n_hidden = 64;
+constexpr int n_l2 = 16;
+
+/// Fixed point scales of the activations and of the weights of the last two layers.
+constexpr int activation_scale = 127;
+constexpr int weight_scale_bits = 6;
+
+/**
+ * Output of the first layer from the point of view of both colors,
+ * kept outside of StateData so that the states of the playouts stay
+ * small (see Network::update()).
+ */
+struct Accumulator {
+    alignas(32) int16_t values[Ncolors][n_hidden];
+};
+
+/**
+ * Small quantized network evaluating a position for its player to move.
+ *
+ * The first layer maps the pieces of each color to an accumulator,
+ * which is clipped to [0, 127] and concatenated with the player to
+ * move's half first. A hidden layer of @n_l2 neurons with int8 weights
+ * follows, then the output neuron whose value is a logit scaled by
+ * 127 * 64.
+ *
+ * Weight files are little-endian and laid out as:
+ *
+ *   uint32 magic ("BTNN"), uint32 version (1),
+ *   uint32 n_inputs, uint32 n_hidden, uint32 n_l2,
+ *   int16  biases1[n_hidden],              scaled by 127
+ *   int16  weights1[n_inputs][n_hidden],   scaled by 127
+ *   int32  biases2[n_l2],                  scaled by 127 * 64
+ *   int8   weights2[n_l2][2 * n_hidden],   scaled by 64
+ *   int32  bias3,                          scaled by 127 * 64
+ *   int8   weights3[n_l2],                 scaled by 64
+ *
+ * utils/train_nnue.py writes such files.
+ */
+class Network {
+public:
+    bool load(const std::filesystem::path& fp);
+    [[nodiscard]] double evaluate(Game& game) const;
+    [[nodiscard]] int evaluate_logit(Game& game) const;
+
+private:
+    void refresh(const Game& game, Accumulator& acc) const;
+    const Accumulator& update(Game& game) const;
+
+    // Set by each load(), to tell apart the accumulators of other weights
+    uint64_t m_id = 0;
+
+    alignas(32) int16_t biases1[n_hidden];
+    alignas(32) int16_t weights1[n_inputs][n_hidden];
+    alignas(32) int32_t biases2[n_l2];
+    alignas(32) int8_t weights2[n_l2][2 * n_hidden];
+    int32_t bias3;
+    alignas(32) int8_t weights3[n_l2];
+};
+
+}  // namespace Nnue
+
+#endif // NNUE_H_
@@ -0,0 +1,177 @@
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+
+/**
+ * Instrumentation of the phases of the search, only compiled in
+ * with BT_PROFILE (cmake -DBT_PROFILE=ON). Without it, the macros
+ * below expand to nothing and the search pays nothing.
+ *
+ * The timings are inclusive: expand counts the initial samples it
+ * draws, select the lookups of the nodes it walks through.
+ */
+namespace Profile {
+
+enum Phase {
+    search, select, expand, sample, backpropagate, get_node, Nphases
+};
+
+enum Histogram {
+    selection_depth,    // plies from the root to the selected leaf
+    rollout_length,     // plies of each playout
+    branching,          // children of each node a selection goes through
+    children,           // children of each node of the tree, 0 for the leaves
+    Nhistograms
+};
+
+constexpr const char* phase_names[Nphases] = {
+    "search", "select", "expand", "sample", "backpropagate", "get_node"
+};
+constexpr const char* histogram_names[Nhistograms] = {
+    "selection_depth", "rollout_length", "branching", "children"
+};
+
+/// Values past the last bucket are counted in it.
+constexpr int n_buckets = 128;
+
+/// Cycles on x86-64, nanoseconds elsewhere
+inline uint64_t ticks() {
+#if defined(__x86_64__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+struct Counters {
+    std::array<uint64_t, Nphases> cycles{};
+    std::array<uint64_t, Nphases> calls{};
+    std::array<std::array<uint64_t, n_buckets>, Nhistograms> histograms{};
+
+    void reset() { *this = Counters{}; }
+
+    void record(Histogram h, int value) {
+        ++histograms[h][std::clamp(value, 0, n_buckets - 1)];
+    }
+
+    /// Count, mean, median, 90th percentile and maximum of @h.
+    struct Summary {
+        uint64_t n = 0;
+        double mean = 0.0;
+        int p50 = 0, p90 = 0, max = 0;
+    };
+
+    Summary summary(Histogram h) const {
+        Summary s;
+        double sum = 0.0;
+        for (int v = 0; v < n_buckets; ++v) {
+            s.n += histograms[h][v];
+            sum += double(v) * histograms[h][v];
+            if (histograms[h][v])
+                s.max = v;
+        }
+        if (s.n == 0)
+            return s;
+        s.mean = sum / s.n;
+
+        uint64_t seen = 0;
+        bool p50_found = false;
+        for (int v = 0; v < n_buckets; ++v) {
+            seen += histograms[h][v];
+            if (!p50_found && 2 * seen >= s.n) {
+                s.p50 = v;
+                p50_found = true;
+            }
+            if (10 * seen >= 9 * s.n) {
+                s.p90 = v;
+                break;
+            }
+        }
+        return s;
+    }
+
+    void print(std::ostream& out) const {
+        const double total = std::max<uint64_t>(cycles[search], 1);
+        out << "Phase            calls      Mcycles   cycles/call   % of search\n" << std::fixed;
+        for (int p = 0; p < Nphases; ++p) {
+            out << std::left << std::setw(14) << phase_names[p] << std::right
+                << std::setw(8) << calls[p]
+                << std::setw(13) << std::setprecision(2) << cycles[p] / 1e6
+                << std::setw(14) << std::setprecision(0) << (calls[p] ? double(cycles[p]) / calls[p] : 0.0)
+                << std::setw(14) << std::setprecision(1) << 100.0 * cycles[p] / total << '\n';
+        }
+        for (int h = 0; h < Nhistograms; ++h) {
+            Summary s = summary(Histogram(h));
+            out << std::left << std::setw(16) << histogram_names[h] << std::right
+                << "n " << s.n << ", mean " << std::setprecision(1) << s.mean
+                << ", median " << s.p50 << ", p90 " << s.p90 << ", max " << s.max << '\n';
+        }
+        out << std::defaultfloat;
+    }
+
+    void write_json(std::ostream& out) const {
+        out << "{\"phases\": {";
+        for (int p = 0; p < Nphases; ++p) {
+            out << (p ? ", " : "") << '"' << phase_names[p] << "\": {\"calls\": " << calls[p]
+                << ", \"cycles\": " << cycles[p] << '}';
+        }
+        out << "}, \"histograms\": {";
+        for (int h = 0; h < Nhistograms; ++h) {
+            Summary s = summary(Histogram(h));
+            out << (h ? ", " : "") << '"' << histogram_names[h] << "\": {\"n\": " << s.n
+                << ", \"mean\": " << s.mean << ", \"median\": " << s.p50
+                << ", \"p90\": " << s.p90 << ", \"max\": " << s.max << ", \"buckets\": [";
+            // Trailing empty buckets are left out
+            for (int v = 0; v <= s.max && s.n; ++v)
+                out << (v ? ", " : "") << histograms[h][v];
+            out << "]}";
+        }
+        out << "}}";
+    }
+};
+
+/// Adds the ticks of its lifetime to a phase of @counters.
+class Timer {
+public:
+    Timer(Counters& counters, Phase phase)
+        : m_counters{ counters }, m_phase{ phase }, m_start{ ticks() } {}
+    ~Timer() {
+        m_counters.cycles[m_phase] += ticks() - m_start;
+        ++m_counters.calls[m_phase];
+    }
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+private:
+    Counters& m_counters;
+    Phase m_phase;
+    uint64_t m_start;
+};
+
+} // namespace Profile
+
+#ifdef BT_PROFILE
+#define BT_PROFILE_CONCAT_(a, b) a##b
+#define BT_PROFILE_CONCAT(a, b) BT_PROFILE_CONCAT_(a, b)
+#define BT_PROFILE_SCOPE(counters, phase) \
+    Profile::Timer BT_PROFILE_CONCAT(profile_timer_, __LINE__){ counters, Profile::phase }
+#define BT_PROFILE_RECORD(counters, histogram, value) (counters).record(Profile::histogram, value)
+#else
+#define BT_PROFILE_SCOPE(counters, phase) ((void)0)
+#define BT_PROFILE_RECORD(counters, histogram, value) ((void)0)
+#endif
+
+#endif // PROFILE_H_
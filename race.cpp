@@ -0,0 +1,153 @@
+#include "race.h"
+#include "types.h"
+#include "bitboard.h"
+#include "game.h"
+
+
+namespace {
+
+    /// Largest number of potential interceptors searched
+    constexpr int max_interceptors = 4;
+    /// Largest number of opponent's moves searched for a single runner
+    constexpr int node_budget = 2048;
+
+    /**
+     * Squares from which a black piece may reach a square on or next to
+     * the forward cone of a white piece on @sq. Black pieces outside of
+     * it can never block nor capture that piece, and stay outside of it
+     * whatever both sides play.
+     */
+    Bitboard interceptors_area(Square sq) {
+        Bitboard span = span_bb(Color::white, sq) & ~row_bb(sq);
+        return span | shift<Direction::left>(span) | shift<Direction::right>(span);
+    }
+
+    /**
+     * Search of the race of a white runner against black pieces
+     * moving down the board, the obstacles being the other white pieces.
+     */
+    class Search {
+    public:
+        explicit Search(bool can_pass) : can_pass{ can_pass } {}
+
+        bool runner_wins(Square runner, Bitboard defenders, Bitboard obstacles, Action* action = nullptr);
+        bool defender_loses(Square runner, Bitboard defenders, Bitboard obstacles);
+
+    private:
+        bool can_pass;
+        int budget = node_budget;
+    };
+
+    /**
+     * Whether the runner to move on @runner wins, in which case
+     * its first move is stored in @action.
+     */
+    bool Search::runner_wins(Square runner, Bitboard defenders, Bitboard obstacles, Action* action) {
+        Bitboard b = square_bb(runner);
+        Bitboard targets = (shift<Direction::up>(b) & ~(defenders | obstacles))
+                         | (attacks<Color::white>(b) & ~obstacles);
+
+        if (Bitboard goals = targets & BB::Row8) {
+            if (action)
+                *action = make_action(runner, lsb(goals));
+            return true;
+        }
+
+        while (targets) {
+            Square to = pop_lsb(targets);
+            if (defender_loses(to, defenders & ~square_bb(to), obstacles)) {
+                if (action)
+                    *action = make_action(runner, to);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Whether every move of the opponent loses the race, the
+     * runner being on @runner.
+     */
+    bool Search::defender_loses(Square runner, Bitboard defenders, Bitboard obstacles) {
+        Bitboard b = square_bb(runner);
+        if (--budget < 0 || (attacks<Color::white>(b) & defenders))
+            return false;
+
+        // The pieces which left the area of the runner can only spend tempo
+        Bitboard area = interceptors_area(runner);
+        bool pass = can_pass || (defenders & ~area);
+        defenders &= area;
+        obstacles &= span_bb(Color::white, runner);
+
+        bool moved = false;
+        Bitboard pcs = defenders;
+        while (pcs) {
+            Bitboard from = square_bb(pop_lsb(pcs));
+            Bitboard targets = (shift<Direction::down>(from) & ~(defenders | obstacles | b))
+                             | (attacks<Color::black>(from) & ~defenders);
+
+            while (targets) {
+                Bitboard to = square_bb(pop_lsb(targets));
+                moved = true;
+                if (!runner_wins(runner, defenders ^ from ^ to, obstacles & ~to))
+                    return false;
+            }
+        }
+
+        // Passing, or having no move at all, gives a free move to the runner
+        return (moved && !pass) || runner_wins(runner, defenders, obstacles);
+    }
+
+    /**
+     * Same as race() for white, with the black pieces on @theirs.
+     */
+    RaceResult race_white(Bitboard ours, Bitboard theirs, Bitboard candidates, bool to_move) {
+        if (!theirs)
+            return { 0, Action::none };
+
+        // Number of moves the opponent needs to reach our first row
+        const int their_fastest = to_integral(row_of(lsb(theirs)));
+
+        // From the most advanced candidate, as the race only gets longer
+        candidates &= ours;
+        while (candidates) {
+            Square sq = msb(candidates);
+            candidates ^= square_bb(sq);
+
+            int moves = 7 - to_integral(row_of(sq));
+            if (to_move ? moves > their_fastest : moves >= their_fastest)
+                break;
+
+            Bitboard area = interceptors_area(sq);
+            if (count(theirs & area) > max_interceptors)
+                continue;
+
+            Search search{ bool(theirs & ~area) };
+            Action action = Action::none;
+            bool win = to_move ? search.runner_wins(sq, theirs & area, ours ^ square_bb(sq), &action)
+                               : search.defender_loses(sq, theirs & area, ours ^ square_bb(sq));
+
+            if (win)
+                return { to_move ? 2 * moves - 1 : 2 * moves, action };
+        }
+
+        return { 0, Action::none };
+    }
+
+}  // namespace
+
+
+RaceResult race(Color c, Bitboard ours, Bitboard theirs, Bitboard candidates, bool to_move) {
+    if (c == Color::white)
+        return race_white(ours, theirs, candidates, to_move);
+
+    RaceResult result = race_white(flip_vertical(ours), flip_vertical(theirs), flip_vertical(candidates), to_move);
+    if (result.action != Action::none)
+        result.action = relative(Color::black, result.action);
+    return result;
+}
+
+RaceResult race(const Game& game, Color c) {
+    return race(c, game.pieces(c), game.pieces(opposite_of(c)),
+                game.features(c).runners, game.player_to_move() == c);
+}
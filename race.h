@@ -0,0 +1,34 @@
+#ifndef RACE_H_
+#define RACE_H_
+
+#include "types.h"
+#include "bitboard.h"
+
+
+class Game;
+
+/// A forced win by a single runner.
+struct RaceResult {
+    int plies;      // Number of plies until the runner reaches its last row, 0 if no race is decided
+    Action action;  // First move of the runner when its side is to move
+};
+
+/**
+ * Look for a piece of color @c which reaches its last row whatever
+ * its opponent does, before any piece of the opponent can reach its
+ * own last row.
+ *
+ * The runner is considered alone: our other pieces stay where they are,
+ * while every piece of the opponent may move. Only the opponent's pieces
+ * able to reach a square on or next to the runner's forward cone can
+ * interfere, the others only spend tempo. The runner's fate against those
+ * is decided by an exhaustive search, which is skipped for the pieces
+ * with more than a handful of potential interceptors.
+ *
+ * The candidates are the runners of Features, i.e. the pieces with
+ * less than two enemy pieces in their span.
+ */
+RaceResult race(const Game& game, Color c);
+RaceResult race(Color c, Bitboard ours, Bitboard theirs, Bitboard candidates, bool to_move);
+
+#endif // RACE_H_
@@ -0,0 +1,113 @@
+#ifndef RANDOM_H_
+#define RANDOM_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <random>
+
+
+/**
+ * Seeded random streams of the engines.
+ *
+ * Every engine draws its random numbers from its own stream, keyed
+ * by the global seed, the component it belongs to, the stream index
+ * of its thread and the number of streams of that component its
+ * thread opened before. With the same seed, and the same stream
+ * index set on each thread, a search does the same work from one
+ * run to the next.
+ *
+ * Without a seed, one is drawn from std::random_device on first use.
+ * Threads which do not set their stream index get a distinct one,
+ * in the order in which they open their first stream.
+ */
+namespace Random {
+
+enum class Component {
+    mcts, agent, agent_random, Ncomponents
+};
+
+/// Finalizer of SplitMix64, a bijection with good avalanche
+constexpr uint64_t mix(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * Counter-based generator: the n-th number of the stream of @key is
+ * a hash of the key and of n, as in SplitMix64, so that it costs a
+ * few multiplications and the state fits in two words.
+ */
+class Rng {
+public:
+    using result_type = uint64_t;
+
+    explicit Rng(uint64_t key = 0) : m_key{ mix(key) } {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type(0); }
+
+    result_type operator()() { return mix(m_key + ++m_counter * 0x9e3779b97f4a7c15ULL); }
+
+    [[nodiscard]] uint64_t counter() const { return m_counter; }
+
+private:
+    uint64_t m_key;
+    uint64_t m_counter = 0;
+};
+
+namespace detail {
+    inline std::atomic<uint64_t> global_seed{ 0 };
+    inline std::atomic<uint64_t> next_thread_stream{ 0 };
+
+    // Streams of the threads which did not set their index, kept
+    // apart from the indices set with set_thread_stream()
+    constexpr uint64_t unset_stream = 1ULL << 63;
+
+    struct ThreadStreams {
+        uint64_t index = unset_stream;
+        std::array<uint64_t, size_t(Component::Ncomponents)> opened{};
+    };
+    inline thread_local ThreadStreams thread_streams;
+}
+
+/// Seed all the streams opened from now on with @seed, 0 to draw one.
+inline void set_seed(uint64_t seed) {
+    detail::global_seed.store(seed, std::memory_order_relaxed);
+}
+
+inline uint64_t seed() {
+    uint64_t s = detail::global_seed.load(std::memory_order_relaxed);
+    if (s)
+        return s;
+    std::random_device rd;
+    uint64_t drawn = (uint64_t(rd()) << 32 | rd()) | 1;
+    // Another thread may have drawn one first
+    return detail::global_seed.compare_exchange_strong(s, drawn) ? drawn : s;
+}
+
+/**
+ * Index of the streams the calling thread opens from now on, such as
+ * the number of the thread or of the game it plays. It restarts the
+ * count of the streams opened by the thread.
+ */
+inline void set_thread_stream(uint64_t index) {
+    detail::thread_streams = { index & ~detail::unset_stream, {} };
+}
+
+/// Next stream of the component @c for the calling thread.
+inline Rng stream(Component c) {
+    auto& streams = detail::thread_streams;
+    if (streams.index == detail::unset_stream)
+        streams.index = detail::unset_stream | detail::next_thread_stream++;
+
+    uint64_t key = mix(seed());
+    key = mix(key + uint64_t(c));
+    key = mix(key + streams.index);
+    return Rng{ key + streams.opened[size_t(c)]++ };
+}
+
+} // namespace Random
+
+#endif // RANDOM_H_
@@ -0,0 +1,150 @@
+#include "record.h"
+#include "types.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+
+namespace Records {
+
+namespace {
+
+    template<typename T>
+    void append(std::vector<char>& buffer, T value) {
+        const char* bytes = reinterpret_cast<const char*>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    template<typename T>
+    bool read(std::istream& is, T& value) {
+        return bool(is.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+
+}  // namespace
+
+/**
+ * Store @counts, scaled down proportionally if the largest of
+ * them does not fit in 16 bits.
+ */
+void Record::set_visits(const std::vector<std::pair<Action, int>>& counts) {
+    int max = 0;
+    for (auto [a, n] : counts)
+        max = std::max(max, n);
+    const double scale = max > UINT16_MAX ? double(UINT16_MAX) / max : 1.0;
+
+    visits.clear();
+    for (auto [a, n] : counts)
+        visits.emplace_back(a, uint16_t(n * scale));
+}
+
+
+Writer::Writer(std::filesystem::path prefix, size_t max_file_bytes, size_t buffer_bytes)
+    : m_prefix{ std::move(prefix) }
+    , max_file_bytes{ max_file_bytes }
+    , buffer_bytes{ buffer_bytes }
+{
+    m_buffer.reserve(buffer_bytes + 4096);
+}
+
+Writer::~Writer() {
+    flush();
+}
+
+/**
+ * Close the current file and open the next one, starting it with
+ * the header. Nothing is opened until the first record comes.
+ */
+bool Writer::open_next() {
+    if (m_ofs.is_open())
+        m_ofs.close();
+
+    std::ostringstream name;
+    name << m_prefix.filename().string() << '-' << std::setw(5) << std::setfill('0') << file_index++ << ".bin";
+    auto fp = m_prefix.parent_path() / name.str();
+
+    m_ofs.open(fp, std::ios::binary | std::ios::trunc);
+    if (!m_ofs) {
+        std::cerr << "Failed to open record file " << fp << std::endl;
+        return false;
+    }
+    append(m_buffer, magic);
+    append(m_buffer, version);
+    file_bytes = header_size;
+    return true;
+}
+
+bool Writer::write(const Record& record) {
+    if (!m_ofs.is_open() || file_bytes >= max_file_bytes) {
+        if (!flush() || !open_next())
+            return false;
+    }
+
+    append(m_buffer, record.white);
+    append(m_buffer, record.black);
+    append(m_buffer, uint8_t(record.side));
+    append(m_buffer, record.result);
+    append(m_buffer, record.ply);
+    const size_t n = std::min<size_t>(record.visits.size(), UINT8_MAX);
+    append(m_buffer, uint8_t(n));
+    for (size_t i = 0; i < n; ++i) {
+        append(m_buffer, to_integral(record.visits[i].first));
+        append(m_buffer, record.visits[i].second);
+    }
+
+    file_bytes += fixed_size + 4 * n;
+    ++records_count;
+
+    return m_buffer.size() < buffer_bytes || flush();
+}
+
+bool Writer::flush() {
+    if (m_buffer.empty())
+        return true;
+    bool ok = m_ofs.is_open()
+        && m_ofs.write(m_buffer.data(), std::streamsize(m_buffer.size()))
+        && m_ofs.flush();
+    m_buffer.clear();
+    if (!ok)
+        std::cerr << "Failed to write records of " << m_prefix << std::endl;
+    return ok;
+}
+
+
+Reader::Reader(const std::filesystem::path& fp)
+    : m_ifs{ fp, std::ios::binary }
+{
+    uint32_t header[2];
+    m_ok = m_ifs && read(m_ifs, header[0]) && read(m_ifs, header[1])
+        && header[0] == magic && header[1] == version;
+    if (!m_ok)
+        std::cerr << "Invalid record file " << fp << std::endl;
+}
+
+/**
+ * Read the next record into @record, return false at the end of
+ * the file or if the file is truncated.
+ */
+bool Reader::next(Record& record) {
+    if (!m_ok)
+        return false;
+
+    uint8_t side, n;
+    if (!read(m_ifs, record.white) || !read(m_ifs, record.black) || !read(m_ifs, side)
+        || !read(m_ifs, record.result) || !read(m_ifs, record.ply) || !read(m_ifs, n))
+        return false;
+
+    record.side = Color(side);
+    record.visits.resize(n);
+    for (auto& [action, visits] : record.visits) {
+        uint16_t a;
+        if (!read(m_ifs, a) || !read(m_ifs, visits))
+            return false;
+        action = Action(a);
+    }
+    return true;
+}
+
+} // namespace Records
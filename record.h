@@ -0,0 +1,103 @@
+#ifndef RECORD_H_
+#define RECORD_H_
+
+#include "types.h"
+#include "bitboard.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+/**
+ * Self-play records: a position, the visit distribution of the search
+ * at its root and the final result of the game.
+ *
+ * Record files are little-endian and laid out as:
+ *
+ *   uint32 magic ("BTSP"), uint32 version (1),
+ *   then records until the end of the file, each of them being
+ *
+ *   uint64 white, uint64 black   bitboards of the position
+ *   uint8  side                  0 if white is to move, 1 if black is
+ *   int8   result                1 if the player to move won the game, -1 otherwise
+ *   uint16 ply                   plies played since the start position
+ *   uint8  n_actions             size of the visit distribution
+ *   n_actions times:
+ *     uint16 action              as in types.h
+ *     uint16 visits              scaled down if the largest count does not fit
+ *
+ * utils/records.py reads them from python.
+ */
+namespace Records {
+
+constexpr uint32_t magic = 0x50535442;   // "BTSP"
+constexpr uint32_t version = 1;
+constexpr size_t header_size = 8;
+constexpr size_t fixed_size = 21;
+
+struct Record {
+    Bitboard white = 0;
+    Bitboard black = 0;
+    Color side = Color::white;
+    int8_t result = 0;
+    uint16_t ply = 0;
+    std::vector<std::pair<Action, uint16_t>> visits;
+
+    void set_visits(const std::vector<std::pair<Action, int>>& counts);
+    [[nodiscard]] size_t size() const { return fixed_size + 4 * visits.size(); }
+    bool operator==(const Record&) const = default;
+};
+
+/**
+ * Buffered writer of records, owned by a single thread so that
+ * writing never takes a lock. Its files are named
+ * @prefix-00000.bin, @prefix-00001.bin... and a new one is started
+ * once the current one holds at least @max_file_bytes.
+ */
+class Writer {
+public:
+    Writer(std::filesystem::path prefix, size_t max_file_bytes, size_t buffer_bytes = 1 << 20);
+    ~Writer();
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    bool write(const Record& record);
+    bool flush();
+    [[nodiscard]] long n_records() const { return records_count; }
+    [[nodiscard]] int n_files() const { return file_index; }
+
+private:
+    bool open_next();
+
+    std::filesystem::path m_prefix;
+    size_t max_file_bytes;
+    size_t buffer_bytes;
+    std::vector<char> m_buffer;
+    std::ofstream m_ofs;
+    size_t file_bytes = 0;
+    int file_index = 0;
+    long records_count = 0;
+};
+
+/**
+ * Streaming reader of a record file.
+ */
+class Reader {
+public:
+    explicit Reader(const std::filesystem::path& fp);
+
+    bool next(Record& record);
+    [[nodiscard]] bool ok() const { return m_ok; }
+
+private:
+    std::ifstream m_ifs;
+    bool m_ok;
+};
+
+} // namespace Records
+
+#endif // RECORD_H_
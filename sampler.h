@@ -0,0 +1,100 @@
+#ifndef SAMPLER_H_
+#define SAMPLER_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+
+/// Running statistics of the rewards, in [0, 1], of one candidate.
+struct SampleStats {
+    double total = 0.0;
+    double squares = 0.0;
+    int n = 0;
+
+    void add(double reward) {
+        total += reward;
+        squares += reward * reward;
+        ++n;
+    }
+
+    double mean() const { return total / n; }
+
+    /**
+     * Half width of the confidence interval of the mean, the
+     * smallest of the Hoeffding and the empirical Bernstein bounds,
+     * each of them holding with probability 1 - exp(-@log_term).
+     */
+    double radius(double log_term) const {
+        double variance = std::max(0.0, squares / n - mean() * mean());
+        double hoeffding = std::sqrt(log_term / (2.0 * n));
+        double bernstein = std::sqrt(2.0 * variance * log_term / n) + 3.0 * log_term / n;
+        return std::min(hoeffding, bernstein);
+    }
+};
+
+/**
+ * Spread at most @budget rewards, drawn with @sample(i), over the
+ * candidates of @stats so as to tell which one is the best.
+ *
+ * Every candidate is first sampled @min_samples times (fewer if the
+ * budget is too small, but at least once). The rest of the
+ * budget goes, one sample at a time, to the candidate with the widest
+ * confidence interval among those not decided yet: a candidate is
+ * decided once it is confidently worse than one of its siblings, or
+ * confidently better than all of them, at the error level @delta.
+ * The sampling stops early when every candidate is decided.
+ *
+ * Return the number of rewards drawn.
+ */
+template<typename F>
+int adaptive_sample(std::vector<SampleStats>& stats, int budget, F sample,
+                    int min_samples = 2, double delta = 0.1) {
+    const size_t n = stats.size();
+    // Both bounds are taken for every candidate: split delta between them
+    const double log_term = std::log(4.0 * n / delta);
+    int spent = 0;
+    min_samples = std::max(1, std::min(min_samples, budget / int(n)));
+
+    for (size_t i = 0; i < n; ++i)
+        for (int k = 0; k < min_samples; ++k, ++spent)
+            stats[i].add(sample(i));
+
+    std::vector<double> lower(n), upper(n);
+
+    while (spent < budget) {
+        // The two largest upper bounds, to compare each candidate with
+        // the best of the others
+        double best_lower = 0.0, first_upper = 0.0, second_upper = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            double r = stats[i].radius(log_term);
+            lower[i] = stats[i].mean() - r;
+            upper[i] = stats[i].mean() + r;
+            best_lower = std::max(best_lower, lower[i]);
+            second_upper = std::max(second_upper, std::min(first_upper, upper[i]));
+            first_upper = std::max(first_upper, upper[i]);
+        }
+
+        size_t next = n;
+        double highest = -1.0;
+        for (size_t i = 0; i < n; ++i) {
+            double others_upper = upper[i] == first_upper ? second_upper : first_upper;
+            bool decided = upper[i] < best_lower || lower[i] > others_upper;
+            if (!decided && upper[i] > highest) {
+                highest = upper[i];
+                next = i;
+            }
+        }
+
+        if (next == n)
+            break;
+
+        stats[next].add(sample(next));
+        ++spent;
+    }
+
+    return spent;
+}
+
+#endif // SAMPLER_H_
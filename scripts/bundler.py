@@ -1,5 +1,6 @@
 #!/usr/bin/env python3
 
+import re
 import sys
 
 project_dir = '~/code/projects/codinGame/breakthrough'
@@ -9,6 +10,7 @@ with open(sources_file) as sources:
     for source in sources.readlines():
         files.append(f"../{format(source.strip())}")
 output = 'btbundled.cpp'
+guard = re.compile(r'#(ifndef|define|endif //) \w+_H_\s*$')
 optim_header = """
 #undef _GLIBCXX_DEBUG // disable run-time bound checking, etc
 #pragma GCC optimize("Ofast,inline") // Ofast = O3,fast-math,allow-store-data-races,no-protect-parens
@@ -24,9 +26,8 @@ with open(output, "w+") as out:
     for file in files:
         with open(file) as f:
             for line in f.readlines():
-                if (line.startswith('#ifndef') or
-                    line.startswith('#define') or
-                    line.startswith('#endif') or
+                # Drop the include guards, but keep the other conditionals
+                if (guard.match(line) or
                     line.startswith('#include "')):
                     continue;
                 out.write(line)
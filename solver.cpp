@@ -0,0 +1,179 @@
+#include "solver.h"
+#include "types.h"
+#include "bitboard.h"
+#include "game.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+
+namespace {
+
+    constexpr uint32_t infinite = 1u << 30;
+
+    /// Add proof numbers, saturating at @infinite.
+    uint32_t sum(uint64_t a, uint64_t b) {
+        return uint32_t(std::min<uint64_t>(infinite, a + b));
+    }
+
+}  // namespace
+
+
+Solver::Solver(Game& game)
+    : m_game{game}
+{
+    for (auto& actions : m_actions)
+        actions.reserve(max_n_moves);
+}
+
+/**
+ * Set the size of the table. It is only allocated
+ * on the first call to solve().
+ */
+void Solver::set_memory_budget(size_t mb) {
+    memory_budget = mb << 20;
+    m_table.clear();
+}
+
+void Solver::clear() {
+    std::fill(m_table.begin(), m_table.end(), Entry{});
+}
+
+/**
+ * Each key maps to a bucket of two entries, so the
+ * index of its first entry is always even.
+ */
+Solver::Entry* Solver::lookup(Key key) {
+    Entry* bucket = &m_table[key & (m_table.size() - 2)];
+    return bucket[0].key == key && bucket[0].work ? &bucket[0]
+         : bucket[1].key == key && bucket[1].work ? &bucket[1]
+         : nullptr;
+}
+
+/**
+ * Store the numbers of a position, replacing the entry of the
+ * bucket which took the least work to compute. The position just
+ * searched is always stored, otherwise the search could not progress.
+ */
+void Solver::store(Key key, uint32_t phi, uint32_t delta, uint32_t work) {
+    Entry* bucket = &m_table[key & (m_table.size() - 2)];
+    Entry* entry = bucket[0].key == key ? &bucket[0]
+                 : bucket[1].key == key ? &bucket[1]
+                 : bucket[0].work <= bucket[1].work ? &bucket[0]
+                 : &bucket[1];
+    *entry = Entry{ key, phi, delta, std::max(work, 1u) };
+}
+
+/**
+ * Multiple iterative deepening: search below the current position
+ * until its proof number reaches @th_phi or its disproof number
+ * reaches @th_delta.
+ */
+void Solver::mid(uint32_t th_phi, uint32_t th_delta, int ply) {
+    ++nodes_count;
+    Key key = m_game.key();
+    long start_count = nodes_count;
+
+    // Our opponent reached our first row
+    if (m_game.is_lost()) {
+        store(key, infinite, 0, 1);
+        return;
+    }
+
+    // A piece one step away from its goal always has a winning move
+    Color us = m_game.player_to_move();
+    if (ply > 0 && (m_game.pieces(us) & row_bb(relative(us, Row::seven)))) {
+        store(key, 0, infinite, 1);
+        return;
+    }
+
+    auto& actions = m_actions[ply];
+    m_game.compute_valid_actions(actions);
+
+    // No pieces left
+    if (actions.empty() || ply >= max_depth - 1) {
+        store(key, infinite, 0, 1);
+        return;
+    }
+
+    while (true) {
+        // phi is the smallest delta of the children, delta the sum of their phi
+        uint32_t delta = 0;
+        uint32_t delta_c1 = infinite;
+        uint32_t delta_c2 = infinite;
+        uint32_t phi_c1 = infinite;
+        size_t c1 = 0;
+
+        for (size_t i = 0; i < actions.size(); ++i) {
+            const Entry* child = lookup(m_game.key_after(actions[i]));
+            uint32_t child_phi = child ? child->phi : 1;
+            uint32_t child_delta = child ? child->delta : 1;
+
+            delta = sum(delta, child_phi);
+            if (child_delta < delta_c1) {
+                delta_c2 = delta_c1;
+                delta_c1 = child_delta;
+                phi_c1 = child_phi;
+                c1 = i;
+            }
+            else if (child_delta < delta_c2) {
+                delta_c2 = child_delta;
+            }
+        }
+        uint32_t phi = delta_c1;
+
+        if (phi >= th_phi || delta >= th_delta || aborted) {
+            if (ply == 0 && phi == 0)
+                best = actions[c1];
+            store(key, phi, delta, uint32_t(std::min<long>(nodes_count - start_count + 1, infinite)));
+            return;
+        }
+
+        // Search the most proving child until it is either no longer
+        // the most proving one, or it exceeds our own thresholds
+        Action action = actions[c1];
+        m_game.apply(action, m_states[ply]);
+        mid(sum(th_delta - delta, phi_c1), std::min(th_phi, sum(delta_c2, 1)), ply + 1);
+        m_game.undo(action);
+
+        if (nodes_count >= node_limit)
+            aborted = true;
+    }
+}
+
+/**
+ * Try to prove a win or a loss for the player to move in the
+ * current position within @node_limit nodes. In the case of a
+ * win, the returned result also contains the winning action.
+ */
+SolverResult Solver::solve() {
+    if (m_table.empty()) {
+        size_t n_entries = 2;
+        while (2 * n_entries * sizeof(Entry) <= memory_budget)
+            n_entries *= 2;
+        m_table.assign(n_entries, Entry{});
+    }
+
+    nodes_count = 0;
+    aborted = false;
+    best = Action::none;
+
+    mid(infinite, infinite, 0);
+
+    const Entry* root = lookup(m_game.key());
+    last_proof = root == nullptr ? Proof::unknown
+               : root->phi == 0 ? Proof::win
+               : root->delta == 0 ? Proof::loss
+               : Proof::unknown;
+
+    return { last_proof, last_proof == Proof::win ? best : Action::none };
+}
+
+void Solver::print_counters(std::ostream& out) const {
+    out << "Solver nodes: " << nodes_count << '\n'
+        << "Solver result: " << (last_proof == Proof::win ? "win"
+                                 : last_proof == Proof::loss ? "loss"
+                                 : "unknown") << '\n'
+        << std::endl;
+}
@@ -0,0 +1,65 @@
+#ifndef SOLVER_H_
+#define SOLVER_H_
+
+#include "types.h"
+#include "game.h"
+
+#include <iosfwd>
+#include <vector>
+
+
+enum class Proof : uint8_t {
+    unknown, win, loss
+};
+
+/// Result of a search, from the point of view of the player to move.
+struct SolverResult {
+    Proof proof;
+    Action action;
+};
+
+/**
+ * Depth-first proof-number search (df-pn).
+ *
+ * Proves whether the player to move in a position wins or loses,
+ * within a node budget. The proof and disproof numbers are kept in
+ * a fixed size table so the memory used is bounded.
+ */
+class Solver {
+public:
+    Solver(Game& game);
+    SolverResult solve();
+
+    void set_memory_budget(size_t mb);
+    void set_node_limit(long n) { node_limit = n; }
+    void clear();
+    void print_counters(std::ostream&) const;
+
+private:
+    /// Proof number (phi) and disproof number (delta) of a
+    /// position for its player to move.
+    struct Entry {
+        Key key;
+        uint32_t phi;
+        uint32_t delta;
+        uint32_t work;
+    };
+
+    void mid(uint32_t th_phi, uint32_t th_delta, int ply);
+    Entry* lookup(Key key);
+    void store(Key key, uint32_t phi, uint32_t delta, uint32_t work);
+
+    Game& m_game;
+    StateData m_states[max_depth];
+    std::vector<Action> m_actions[max_depth];
+    std::vector<Entry> m_table;
+    size_t memory_budget = size_t(16) << 20;
+
+    long node_limit = 1000000;
+    long nodes_count = 0;
+    bool aborted = false;
+    Action best = Action::none;
+    Proof last_proof = Proof::unknown;
+};
+
+#endif // SOLVER_H_
@@ -0,0 +1,358 @@
+#include "tablebase.h"
+#include "types.h"
+#include "bitboard.h"
+#include "game.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+
+    constexpr uint32_t magic = 0x31425442;  // "BTB1"
+    constexpr uint32_t version = 1;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t n_us;
+        uint32_t n_them;
+        uint64_t n_entries;
+    };
+
+    /// Number of squares available to the pieces of each side:
+    /// a piece on its last row has already won the game.
+    constexpr int n_squares = 56;
+
+    struct Binomial {
+        uint64_t c[n_squares + 1][Tablebase::max_pieces_per_side + 1] = {};
+
+        constexpr Binomial() {
+            for (int n = 0; n <= n_squares; ++n) {
+                c[n][0] = 1;
+                for (int k = 1; k <= Tablebase::max_pieces_per_side; ++k)
+                    c[n][k] = n == 0 ? 0 : c[n - 1][k - 1] + c[n - 1][k];
+            }
+        }
+    };
+
+    constexpr Binomial binomial{};
+
+    uint64_t n_placements(int k) {
+        return binomial.c[n_squares][k];
+    }
+
+    /**
+     * Colexicographic rank of the set of squares in @bb among
+     * the sets of the same size.
+     */
+    uint64_t rank(Bitboard bb) {
+        uint64_t r = 0;
+        for (int i = 1; bb; ++i)
+            r += binomial.c[to_integral(pop_lsb(bb))][i];
+        return r;
+    }
+
+    /**
+     * Inverse of rank() for sets of @k squares.
+     */
+    Bitboard unrank(uint64_t r, int k) {
+        Bitboard bb = 0;
+        int s = n_squares;
+        for (int i = k; i > 0; --i) {
+            do { --s; } while (binomial.c[s][i] > r);
+            r -= binomial.c[s][i];
+            bb |= Bitboard(1) << s;
+        }
+        return bb;
+    }
+
+    /// Pieces of the player to move are on the rows one to seven,
+    /// their opponent's on the rows two to eight.
+    uint64_t index(Bitboard us, Bitboard them) {
+        return rank(us) * n_placements(count(them)) + rank(them >> 8);
+    }
+
+    /**
+     * Sum of the number of rows each piece advanced, which
+     * increases by exactly one with every non-capturing move.
+     */
+    int level(Bitboard us, Bitboard them) {
+        int ret = 0;
+        for (Row r = Row::one; r < Row::eight; r += 1)
+            ret += to_integral(r) * count(us & row_bb(r))
+                 + (6 - to_integral(r)) * count(them & row_bb(r + 1));
+        return ret;
+    }
+
+    std::filesystem::path table_path(const std::filesystem::path& dir, int n_us, int n_them) {
+        return dir / ("tb_" + std::to_string(n_us) + "v" + std::to_string(n_them) + ".btb");
+    }
+
+    /**
+     * Call @f(begin, end) on @n_threads contiguous chunks of [0, @n).
+     */
+    template<typename F>
+    void parallel_for(uint64_t n, int n_threads, F f) {
+        std::vector<std::thread> threads;
+        uint64_t chunk = (n + n_threads - 1) / n_threads;
+        for (uint64_t begin = 0; begin < n; begin += chunk)
+            threads.emplace_back(f, begin, std::min(n, begin + chunk));
+        for (auto& t : threads)
+            t.join();
+    }
+
+    /**
+     * Tables under construction, one byte per entry.
+     */
+    class Generator {
+    public:
+        void generate(int n_us, int n_them, int n_threads);
+        void write(int n_us, int n_them, const std::filesystem::path& dir) const;
+
+    private:
+        uint8_t evaluate(Bitboard us, Bitboard them) const;
+        uint8_t lookup(Bitboard us, Bitboard them) const {
+            return m_values[count(us)][count(them)][index(us, them)];
+        }
+
+        std::vector<uint8_t> m_values[Tablebase::max_pieces_per_side + 1][Tablebase::max_pieces_per_side + 1];
+    };
+
+    /**
+     * Distance to the end of the game of a position whose
+     * successors were all computed already.
+     */
+    uint8_t Generator::evaluate(Bitboard us, Bitboard them) const {
+        Bitboard empty = ~(us | them);
+        int win = 0;
+        int loss = 0;
+
+        Bitboard pcs = us;
+        while (pcs) {
+            Bitboard from = square_bb(pop_lsb(pcs));
+            Bitboard targets = (forward<Color::white>(from) & empty) | (attacks<Color::white>(from) & ~us);
+
+            while (targets) {
+                Bitboard to = square_bb(pop_lsb(targets));
+                Bitboard them_after = them & ~to;
+
+                if ((to & BB::Row8) || !them_after)
+                    return 1;
+
+                // The successor, seen from our opponent's point of view
+                int d = lookup(flip_vertical(them_after), flip_vertical(us ^ from ^ to)) + 1;
+                if (d & 1)
+                    win = win ? std::min(win, d) : d;
+                else
+                    loss = std::max(loss, d);
+            }
+        }
+
+        // The frontmost piece can always move diagonally
+        assert(win || loss);
+        return win ? win : loss;
+    }
+
+    /**
+     * Compute the tables (@n_us, @n_them) and (@n_them, @n_us)
+     * together by decreasing level, since the non-capturing moves of
+     * one lead to the other. The positions of a level only depend on
+     * the next level, so they are split among the threads.
+     */
+    void Generator::generate(int n_us, int n_them, int n_threads) {
+        std::pair<int, int> tables[2] = { { n_us, n_them }, { n_them, n_us } };
+        const int n_tables = n_us == n_them ? 1 : 2;
+        std::vector<uint8_t> levels[2];
+        constexpr uint8_t impossible = 0xFF;
+
+        for (int t = 0; t < n_tables; ++t) {
+            auto [u, v] = tables[t];
+            uint64_t n_them_placements = n_placements(v);
+            m_values[u][v].assign(n_placements(u) * n_them_placements, 0);
+            levels[t].resize(m_values[u][v].size());
+
+            parallel_for(levels[t].size(), n_threads, [&, u=u, v=v](uint64_t begin, uint64_t end) {
+                for (uint64_t i = begin; i < end; ++i) {
+                    Bitboard us = unrank(i / n_them_placements, u);
+                    Bitboard them = unrank(i % n_them_placements, v) << 8;
+                    levels[t][i] = us & them ? impossible : level(us, them);
+                }
+            });
+        }
+
+        for (int l = 6 * (n_us + n_them); l >= 0; --l) {
+            for (int t = 0; t < n_tables; ++t) {
+                auto [u, v] = tables[t];
+                uint64_t n_them_placements = n_placements(v);
+
+                parallel_for(levels[t].size(), n_threads, [&, u=u, v=v](uint64_t begin, uint64_t end) {
+                    for (uint64_t i = begin; i < end; ++i) {
+                        if (levels[t][i] != l)
+                            continue;
+                        Bitboard us = unrank(i / n_them_placements, u);
+                        Bitboard them = unrank(i % n_them_placements, v) << 8;
+                        m_values[u][v][i] = evaluate(us, them);
+                    }
+                });
+            }
+        }
+    }
+
+    /**
+     * Write a table with its values packed in 6 bits, least
+     * significant bits first.
+     */
+    void Generator::write(int n_us, int n_them, const std::filesystem::path& dir) const {
+        const auto& values = m_values[n_us][n_them];
+        Header header{ magic, version, uint32_t(n_us), uint32_t(n_them), values.size() };
+
+        // One more byte so that probes can always read two bytes
+        std::vector<uint8_t> packed((6 * values.size() + 7) / 8 + 1, 0);
+        for (uint64_t i = 0; i < values.size(); ++i) {
+            uint64_t bit = 6 * i;
+            unsigned v = unsigned(values[i]) << (bit & 7);
+            packed[bit >> 3] |= v & 0xFF;
+            packed[(bit >> 3) + 1] |= v >> 8;
+        }
+
+        std::ofstream ofs{ table_path(dir, n_us, n_them), std::ios::binary };
+        ofs.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        ofs.write(reinterpret_cast<const char*>(packed.data()), packed.size());
+    }
+
+}  // namespace
+
+
+/**
+ * Generate and write in @dir the tables of every position
+ * with at most @max_pieces pieces (up to 9).
+ */
+void Tablebase::generate(int max_pieces, const std::filesystem::path& dir, int n_threads) {
+    // Distances to the end of the game must fit in 6 bits
+    max_pieces = std::min(max_pieces, 9);
+    std::filesystem::create_directories(dir);
+    Generator gen;
+
+    for (int n = 2; n <= max_pieces; ++n) {
+        for (int n_us = std::max(1, n - max_pieces_per_side); 2 * n_us <= n; ++n_us) {
+            int n_them = n - n_us;
+            gen.generate(n_us, n_them, std::max(1, n_threads));
+            gen.write(n_us, n_them, dir);
+            if (n_us != n_them)
+                gen.write(n_them, n_us, dir);
+
+            std::cerr << "Generated tables " << n_us << 'v' << n_them
+                      << " and " << n_them << 'v' << n_us << std::endl;
+        }
+    }
+}
+
+Tablebase::~Tablebase() {
+    for (auto& row : m_tables)
+        for (auto& table : row)
+            if (table.data)
+                munmap(const_cast<uint8_t*>(table.data), table.size);
+}
+
+/**
+ * Memory map every table found in @dir. Return false if
+ * none of them could be loaded.
+ */
+bool Tablebase::load(const std::filesystem::path& dir) {
+    for (int n_us = 1; n_us <= max_pieces_per_side; ++n_us) {
+        for (int n_them = 1; n_them <= max_pieces_per_side; ++n_them) {
+            Table& table = m_tables[n_us][n_them];
+            if (table.data)
+                continue;
+
+            int fd = open(table_path(dir, n_us, n_them).c_str(), O_RDONLY);
+            if (fd < 0)
+                continue;
+
+            struct stat st;
+            void* data = fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(Header)
+                ? mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0)
+                : MAP_FAILED;
+            close(fd);
+            if (data == MAP_FAILED)
+                continue;
+
+            Header header;
+            std::memcpy(&header, data, sizeof(Header));
+            uint64_t n_entries = n_placements(n_us) * n_placements(n_them);
+
+            if (header.magic != magic || header.version != version
+                || header.n_us != uint32_t(n_us) || header.n_them != uint32_t(n_them)
+                || header.n_entries != n_entries
+                || size_t(st.st_size) < sizeof(Header) + (6 * n_entries + 7) / 8 + 1) {
+                std::cerr << "Invalid tablebase " << table_path(dir, n_us, n_them) << std::endl;
+                munmap(data, st.st_size);
+                continue;
+            }
+
+            table.data = static_cast<const uint8_t*>(data);
+            table.size = st.st_size;
+            table.n_entries = n_entries;
+        }
+    }
+
+    // Largest number of pieces for which every table is available
+    m_max_pieces = 0;
+    for (int n = 2; n <= 2 * max_pieces_per_side; ++n) {
+        bool complete = true;
+        for (int n_us = std::max(1, n - max_pieces_per_side); n_us <= std::min(n - 1, max_pieces_per_side); ++n_us)
+            complete &= m_tables[n_us][n - n_us].data != nullptr;
+        if (!complete)
+            break;
+        m_max_pieces = n;
+    }
+
+    return m_max_pieces > 0;
+}
+
+/**
+ * Look up a position where the player to move owns the pieces
+ * of @us and moves up the board.
+ */
+TBResult Tablebase::probe(Bitboard us, Bitboard them) const {
+    int n_us = count(us);
+    int n_them = count(them);
+
+    if (n_us == 0)
+        return { Proof::loss, 0 };
+    if (n_them == 0 || n_us > max_pieces_per_side || n_them > max_pieces_per_side
+        || (us & BB::Row8) || (them & BB::Row1))
+        return { Proof::unknown, 0 };
+
+    const Table& table = m_tables[n_us][n_them];
+    if (!table.data)
+        return { Proof::unknown, 0 };
+
+    uint64_t bit = 6 * index(us, them);
+    const uint8_t* p = table.data + sizeof(Header) + (bit >> 3);
+    int v = ((p[0] | (p[1] << 8)) >> (bit & 7)) & 0x3F;
+
+    return v == 0 ? TBResult{ Proof::unknown, 0 }
+         : TBResult{ v & 1 ? Proof::win : Proof::loss, v };
+}
+
+TBResult Tablebase::probe(const Game& game) const {
+    Color us = game.player_to_move();
+    Bitboard ours = game.pieces(us);
+    Bitboard theirs = game.pieces(opposite_of(us));
+
+    return us == Color::white ? probe(ours, theirs)
+                              : probe(flip_vertical(ours), flip_vertical(theirs));
+}
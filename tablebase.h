@@ -0,0 +1,63 @@
+#ifndef TABLEBASE_H_
+#define TABLEBASE_H_
+
+#include "types.h"
+#include "bitboard.h"
+#include "solver.h"
+
+#include <cstddef>
+#include <filesystem>
+
+
+class Game;
+
+/// Exact result of a position, from the point of view of the player to move.
+struct TBResult {
+    Proof proof;
+    int distance;  // Number of plies until the game ends
+};
+
+/**
+ * Endgame tablebases.
+ *
+ * A table holds every position with @n_us pieces for the player to
+ * move and @n_them for its opponent, seen from the point of view of
+ * the player to move as if it were white (black positions are
+ * flipped vertically). Positions are indexed by the combinatorial
+ * ranks of the two sets of squares, and each one stores its distance
+ * to the end of the game in 6 bits: it is a win if that distance is
+ * odd and a loss if it is even. A value of 0 marks an impossible
+ * placement (two pieces on the same square).
+ *
+ * The tables are generated by backward induction: every move advances
+ * a piece by one row, so a position only depends on positions further
+ * advanced in its own pair of tables, or on tables with fewer pieces.
+ */
+class Tablebase {
+public:
+    Tablebase() = default;
+    ~Tablebase();
+    Tablebase(const Tablebase&) = delete;
+    Tablebase& operator=(const Tablebase&) = delete;
+
+    static void generate(int max_pieces, const std::filesystem::path& dir, int n_threads = 1);
+
+    bool load(const std::filesystem::path& dir);
+    [[nodiscard]] TBResult probe(const Game& game) const;
+    [[nodiscard]] TBResult probe(Bitboard us, Bitboard them) const;
+    [[nodiscard]] int max_pieces() const { return m_max_pieces; }
+
+    static constexpr int max_pieces_per_side = 8;
+
+private:
+    struct Table {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        uint64_t n_entries = 0;
+    };
+
+    Table m_tables[max_pieces_per_side + 1][max_pieces_per_side + 1];
+    int m_max_pieces = 0;
+};
+
+#endif // TABLEBASE_H_
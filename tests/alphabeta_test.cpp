@@ -0,0 +1,66 @@
+#include "types.h"
+#include "alphabeta.h"
+#include "game.h"
+#include "solver.h"
+
+#include <iostream>
+#include <random>
+#include <string>
+
+
+constexpr int default_n_positions = 200;
+constexpr int time_limit_ms = 2000;
+
+/**
+ * Whether the player who just moved in the position of @game has won,
+ * by reaching the last row or capturing every piece of the opponent.
+ */
+bool just_won(const Game& game) {
+    return game.is_lost() || !game.pieces(game.player_to_move());
+}
+
+int main(int argc, char *argv[]) {
+    Game::init();
+    Game game;
+    Solver solver(game);
+    solver.set_node_limit(100000);
+    // A single search keeps its history and killers from one position to
+    // the next, as over the plies of a game
+    AlphaBeta search(game);
+    search.set_time_limit(time_limit_ms);
+    StateData sd;
+    std::mt19937 eng{ 2022 };
+
+    int n_positions = argc > 1 ? std::stoi(argv[1]) : default_n_positions;
+    int n_wins = 0;
+
+    // Endgames with a few pieces on each side, which the player to move wins
+    for (int i = 0; i < n_positions; ++i) {
+        Bitboard white = 0, black = 0;
+        int n_white = 1 + eng() % 4, n_black = 1 + eng() % 4;
+        while (count(white) < n_white)
+            white |= (Bitboard(1) << (eng() % 64)) & ~BB::Row8;
+        while (count(black) < n_black)
+            black |= (Bitboard(1) << (eng() % 64)) & ~(BB::Row1 | white);
+
+        game.set_position(white, black, eng() & 1 ? Color::white : Color::black);
+        if (solver.solve().proof != Proof::win)
+            continue;
+        ++n_wins;
+
+        Action action = search.best_action();
+        int score = search.score();
+        game.apply(action, sd);
+        bool won = just_won(game) || solver.solve().proof == Proof::loss;
+        game.undo(action);
+
+        if (score < AlphaBeta::win_score - max_depth || !won) {
+            std::cout << game.view() << '\n' << "Forced win missed: " << string_of(action)
+                      << " scored " << score << (won ? "" : ", which does not win") << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::cout << n_wins << " forced wins found in " << n_positions << " positions: OK" << std::endl;
+    return EXIT_SUCCESS;
+}
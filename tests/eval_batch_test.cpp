@@ -0,0 +1,80 @@
+#include "types.h"
+#include "game.h"
+#include "eval.h"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+
+constexpr int default_n_games = 1000;
+constexpr int n_random_positions = 100000;
+
+int main(int argc, char *argv[]) {
+    Game::init();
+    Game game;
+    StateData states[max_depth];
+    std::vector<Action> actions;
+    std::mt19937 eng{ 2022 };
+
+    int n_games = argc > 1 ? std::stoi(argv[1]) : default_n_games;
+
+    std::vector<Bitboard> white, black;
+    std::vector<Color> side;
+    std::vector<double> expected;
+
+    for (int i = 0; i < n_games; ++i) {
+        game.reset();
+        int ply = 0;
+
+        while (!game.is_lost()) {
+            game.compute_valid_actions(actions);
+            if (actions.empty())
+                break;
+            std::uniform_int_distribution<> dist(0, actions.size() - 1);
+            game.apply(actions[dist(eng)], states[ply++]);
+
+            white.push_back(game.pieces(Color::white));
+            black.push_back(game.pieces(Color::black));
+            side.push_back(game.player_to_move());
+            expected.push_back(static_eval(game));
+        }
+    }
+
+    // Random boards too, farther from the games' structures, on
+    // which the terms of the evaluation reach their extremes
+    std::mt19937_64 eng64{ 2022 };
+    for (int i = 0; i < n_random_positions; ++i) {
+        Bitboard w = eng64() & eng64() & ~BB::Row8;
+        Bitboard b = eng64() & eng64() & ~(BB::Row1 | w);
+        game.set_position(w, b, eng64() & 1 ? Color::white : Color::black);
+        if (!w || !b || game.is_lost())
+            continue;
+
+        white.push_back(w);
+        black.push_back(b);
+        side.push_back(game.player_to_move());
+        expected.push_back(static_eval(game));
+    }
+
+    const size_t n = expected.size();
+    std::vector<double> scalar(n), batch(n);
+    static_eval_batch_scalar(n, white.data(), black.data(), side.data(), scalar.data());
+    static_eval_batch(n, white.data(), black.data(), side.data(), batch.data());
+
+    for (size_t i = 0; i < n; ++i) {
+        if (scalar[i] == expected[i] && batch[i] == expected[i] && 0.0 <= expected[i] && expected[i] <= 1.0)
+            continue;
+
+        game.set_position(white[i], black[i], side[i]);
+        std::cout << game.view() << '\n'
+                  << "static_eval: " << expected[i]
+                  << " scalar batch: " << scalar[i]
+                  << " batch: " << batch[i] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Batch evaluation of " << n << " positions: OK" << std::endl;
+    return EXIT_SUCCESS;
+}
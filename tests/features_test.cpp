@@ -0,0 +1,120 @@
+#include "types.h"
+#include "game.h"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+
+constexpr int default_n_games = 1000;
+
+/**
+ * Check that the features brought up to date by Game::features()
+ * after Game::apply() and Game::undo() match the ones computed
+ * from scratch.
+ */
+bool check_features(const Game& game) {
+    for (Color c : { Color::white, Color::black }) {
+        if (game.features(c) == game.compute_features(c))
+            continue;
+
+        const Features& f = game.features(c);
+        const Features expected = game.compute_features(c);
+        std::cout << game.view() << '\n'
+                  << (c == Color::white ? "WHITE" : "BLACK")
+                  << " phalanx: " << int(f.phalanx) << " (expected " << int(expected.phalanx) << ")"
+                  << " column: " << int(f.column) << " (expected " << int(expected.column) << ")"
+                  << " levers: " << int(f.levers) << " (expected " << int(expected.levers) << ")"
+                  << " runners: " << f.runners << " (expected " << expected.runners << ")"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Check that copies of @game, made by the copy constructor and by
+ * assignment, play from their own state: reading their features
+ * and playing @a in them leaves the states of @game as they were.
+ */
+bool check_copies(Game& game, Action a) {
+    const StateData before = *game.get_sd();
+    Game copy = game;
+    Game assigned;
+    assigned = game;
+
+    for (Game* g : { &copy, &assigned }) {
+        StateData sd;
+        bool ok = g->get_sd() != game.get_sd() && g->key() == game.key() && check_features(*g);
+        g->apply(a, sd);
+        ok = ok && check_features(*g);
+        g->undo(a);
+        ok = ok && check_features(*g);
+
+        if (!ok || game.get_sd()->features_computed != before.features_computed) {
+            std::cout << game.view() << '\n' << "Copy of the game shares its state" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    Game::init();
+    Game game;
+    StateData states[max_depth];
+    std::vector<Action> actions;
+    Action played[max_depth];
+    std::mt19937 eng{ 2022 };
+
+    int n_games = argc > 1 ? std::stoi(argv[1]) : default_n_games;
+    long n_positions = 0;
+
+    for (int i = 0; i < n_games; ++i) {
+        game.reset();
+        int ply = 0;
+        // The features are only read every few plies, so that
+        // several moves are replayed at once
+        int next_check = 1;
+
+        while (!game.is_lost()) {
+            game.compute_valid_actions(actions);
+            if (actions.empty())
+                break;
+            std::uniform_int_distribution<> dist(0, actions.size() - 1);
+            played[ply] = actions[dist(eng)];
+            game.apply(played[ply], states[ply]);
+            ++ply;
+            ++n_positions;
+
+            if (ply < next_check)
+                continue;
+            next_check = ply + 1 + eng() % 12;
+
+            // Before the features of the current state are brought up to date
+            game.compute_valid_actions(actions);
+            if (!actions.empty() && !check_copies(game, actions[0])) {
+                std::cout << "FAILED copying at ply " << ply << std::endl;
+                return EXIT_FAILURE;
+            }
+
+            if (!check_features(game)) {
+                std::cout << "FAILED after apply at ply " << ply << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+
+        while (ply > 0) {
+            game.undo(played[--ply]);
+
+            if (!check_features(game)) {
+                std::cout << "FAILED after undo at ply " << ply << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    std::cout << "Features of " << n_positions << " positions: OK" << std::endl;
+    return EXIT_SUCCESS;
+}
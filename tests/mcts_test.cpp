@@ -2,16 +2,62 @@
 #include "game.h"
 #include "types.h"
 #include "agentRandom.h"
+#include "nnue.h"
+#include "random.h"
+#include "tablebase.h"
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
 #include <fstream>
+#include <initializer_list>
 #include <iostream>
 #include <limits>
+#include <random>
 #include <sstream>
 #include <string_view>
 
 constexpr auto graphviz_fn = "tree.dot";
 
+constexpr int tb_max_pieces = 3;
+constexpr int n_tb_positions = 500;
+
+// White wins with a7a8, and the race is decided for white after h2h3
+constexpr auto race_position = "4b3/w7/8/8/8/8/7w/8 w";
+constexpr auto start_position = "bbbbbbbb/bbbbbbbb/8/8/8/8/wwwwwwww/wwwwwwww w";
+// Black wins next move unless white captures b2 with c1b2, after which
+// white wins the race
+constexpr auto capture_position = "4b3/8/8/7w/8/8/1b6/2w5 w";
+
+// Any sound search wins nearly every game against random moves: below
+// that, the rewards are most likely scored for the wrong player somewhere
+constexpr int n_strength_games = 20;
+constexpr int strength_iterations = 200;
+constexpr double min_winrate = 0.8;
+
+const std::filesystem::path tb_dir = std::filesystem::temp_directory_path() / "bt_mcts_test";
+const std::filesystem::path nnue_fp = std::filesystem::temp_directory_path() / "bt_mcts_test.nnue";
+
+/**
+ * Write a network whose output does not depend on the position: all
+ * its weights are zero but the output bias, @logit once scaled.
+ */
+void write_constant_network(const std::filesystem::path& fp, double logit) {
+    const uint32_t header[] = { 0x4E4E5442, 1, Nnue::n_inputs, Nnue::n_hidden, Nnue::n_l2 };
+    const std::vector<char> zeros(sizeof(int16_t) * (1 + Nnue::n_inputs) * Nnue::n_hidden
+                                  + sizeof(int32_t) * Nnue::n_l2
+                                  + sizeof(int8_t) * Nnue::n_l2 * 2 * Nnue::n_hidden);
+    const int32_t bias3 = int32_t(logit * (Nnue::activation_scale << Nnue::weight_scale_bits));
+    const int8_t weights3[Nnue::n_l2] = {};
+
+    std::ofstream ofs{ fp, std::ios::binary };
+    ofs.write(reinterpret_cast<const char*>(header), sizeof(header));
+    ofs.write(zeros.data(), zeros.size());
+    ofs.write(reinterpret_cast<const char*>(&bias3), sizeof(bias3));
+    ofs.write(reinterpret_cast<const char*>(weights3), sizeof(weights3));
+}
+
 void any_key() {
     char ch = '\0';
     std::cout << "Press any key to continue..." << std::endl;
@@ -46,6 +92,522 @@ public:
         return res;
     }
 
+    /**
+     * The playouts stopped by the tablebases are scored like the games
+     * they end: sample() returns its reward for the player to move after
+     * the action, 0.0 when the action wins, and sample_leaf() for the
+     * player who moved into the leaf, 1.0 when the leaf is won for it.
+     */
+    bool test_tablebase_rewards(const Tablebase& tb) {
+        std::mt19937_64 eng{ 2022 };
+        std::vector<Action> actions;
+        StateData st;
+        set_tablebase(&tb);
+
+        for (int i = 0; i < n_tb_positions; ++i) {
+            int n_white = 1 + eng() % (tb_max_pieces - 1);
+            int n_black = 1 + eng() % (tb_max_pieces - n_white);
+            Bitboard white = 0, black = 0;
+            while (count(white) < n_white)
+                white |= (Bitboard(1) << (eng() % 64)) & ~BB::Row8;
+            while (count(black) < n_black)
+                black |= (Bitboard(1) << (eng() % 64)) & ~(BB::Row1 | white);
+
+            m_game.set_position(white, black, eng() & 1 ? Color::white : Color::black);
+            if (m_game.is_lost())
+                continue;
+
+            double expected = tb.probe(m_game).proof == Proof::loss ? 1.0 : 0.0;
+            if (sample_leaf() != expected) {
+                std::cout << m_game.view() << "Leaf scored " << sample_leaf()
+                          << " instead of " << expected << std::endl;
+                return false;
+            }
+
+            m_game.compute_valid_actions(actions);
+            for (Action a : actions) {
+                m_game.apply(a, st);
+                expected = m_game.is_lost() || !m_game.pieces(m_game.player_to_move()) ? 0.0
+                         : tb.probe(m_game).proof == Proof::win ? 1.0 : 0.0;
+                m_game.undo(a);
+
+                if (double reward = sample(a); reward != expected) {
+                    std::cout << m_game.view() << string_of(a) << " scored " << reward
+                              << " instead of " << expected << std::endl;
+                    return false;
+                }
+            }
+        }
+
+        set_tablebase(nullptr);
+        m_game.reset();
+        return true;
+    }
+
+    /**
+     * The playouts stopped by the network @net take its estimate for the
+     * player to move after the action, and the leaves its complement for
+     * the player who moved into them.
+     */
+    bool test_network_rewards(const Nnue::Network& net) {
+        std::vector<Action> actions;
+        StateData st;
+        set_network(&net);
+        m_game.reset();
+        bool ok = true;
+
+        double expected = 1.0 - net.evaluate(m_game);
+        if (double reward = sample_leaf(); reward != expected) {
+            std::cout << m_game.view() << "Leaf scored " << reward << " instead of " << expected << std::endl;
+            ok = false;
+        }
+
+        m_game.compute_valid_actions(actions);
+        for (Action a : actions) {
+            m_game.apply(a, st);
+            expected = net.evaluate(m_game);
+            m_game.undo(a);
+
+            if (double reward = sample(a); reward != expected) {
+                std::cout << string_of(a) << " scored " << reward << " instead of " << expected << std::endl;
+                ok = false;
+                break;
+            }
+        }
+
+        set_network(nullptr);
+        return ok;
+    }
+
+    /**
+     * Follow @path from the root as select() would, expanding the nodes
+     * on the way. Return the last edge and its parent.
+     */
+    std::pair<Node*, Edge*> follow(std::initializer_list<const char*> path) {
+        Node* parent = nullptr;
+        Edge* edge = nullptr;
+        for (const char* action : path) {
+            parent = &current_node();
+            if (parent->children.empty())
+                expand(*parent);
+            ++parent->visits;
+            edge = &*std::find(parent->children.begin(), parent->children.end(), action_of(action));
+            apply(*edge);
+        }
+        return { parent, edge };
+    }
+
+    /**
+     * With transposition statistics, the edges reaching the same position
+     * by two move orders read the same exploitation term from its node,
+     * however differently each of them was visited.
+     */
+    bool test_transposition_stats() {
+        m_game.reset();
+        reset(m_game);
+        set_transposition_stats(true);
+        set_exp_cst(0.0);
+        setup_root();
+        bool ok = true;
+
+        auto [parent1, edge1] = follow({ "a2a3", "h7h6", "b2b3" });
+        const Node* node = &current_node();
+        backpropagate(0.25);
+
+        auto [parent2, edge2] = follow({ "b2b3", "h7h6", "a2a3" });
+        if (&current_node() != node) {
+            std::cout << "The move orders reached different nodes" << std::endl;
+            ok = false;
+        }
+        backpropagate(0.75);
+
+        // UCB() reads the child's key from the parent's position
+        auto ucb_at = [&](std::initializer_list<const char*> path, Node* parent, Edge* edge) {
+            follow(path);
+            double ucb = UCB(*parent, *edge);
+            for (size_t i = 0; i < path.size(); ++i)
+                undo();
+            return ucb;
+        };
+        double ucb1 = ucb_at({ "a2a3", "h7h6" }, parent1, edge1);
+        double ucb2 = ucb_at({ "b2b3", "h7h6" }, parent2, edge2);
+        if (ucb1 != ucb2 || ucb1 != node->total / node->updates || node->updates != 2) {
+            std::cout << "Exploitation terms " << ucb1 << " and " << ucb2 << " for a node of "
+                      << node->updates << " updates averaging " << node->total / node->updates << std::endl;
+            ok = false;
+        }
+
+        set_transposition_stats(false);
+        reset(m_game);
+        return ok;
+    }
+
+    /**
+     * The canonical keys after an action are those after the mirrored
+     * action in the mirrored position, and those of the position
+     * reached, along random games. A search sharing the nodes of
+     * mirrored positions then still plays valid actions in both
+     * orientations.
+     */
+    bool test_symmetry() {
+        constexpr int n_games = 20;
+        constexpr int n_plies = 10;
+        std::mt19937 eng{ 2022 };
+        StateData states[max_depth], st;
+        std::vector<Action> actions, mirrored_actions;
+        Game mirrored;
+        bool ok = true;
+
+        for (int g = 0; g < n_games && ok; ++g) {
+            m_game.reset();
+            for (StateData* sd = states; ok && !m_game.is_lost() && m_game.pieces(m_game.player_to_move()); ++sd) {
+                mirrored.set_position(flip_horizontal(m_game.pieces(Color::white)),
+                                      flip_horizontal(m_game.pieces(Color::black)), m_game.player_to_move());
+                mirrored.compute_valid_actions(mirrored_actions);
+                m_game.compute_valid_actions(actions);
+
+                for (Action a : actions) {
+                    Key after = m_game.canonical_key_after(a);
+                    bool valid = std::find(mirrored_actions.begin(), mirrored_actions.end(), mirror(a))
+                                 != mirrored_actions.end();
+                    m_game.apply(a, st);
+                    Key reached = m_game.canonical_key();
+                    m_game.undo(a);
+
+                    if (!valid || after != reached || after != mirrored.canonical_key_after(mirror(a))) {
+                        std::cout << m_game.view() << string_of(a) << (valid ? "" : " not valid once mirrored")
+                                  << " canonical key " << after << ", reached " << reached << ", mirrored "
+                                  << mirrored.canonical_key_after(mirror(a)) << std::endl;
+                        ok = false;
+                        break;
+                    }
+                }
+                m_game.apply(actions[eng() % actions.size()], *sd);
+            }
+        }
+
+        set_symmetry(true);
+        set_n_iterations(500);
+        m_game.reset();
+        reset(m_game);
+        for (int ply = 0; ply < n_plies && ok && !m_game.is_lost(); ++ply) {
+            Action a = ply % 2 == 0 ? best_action() : rand.best_action();
+            m_game.compute_valid_actions(actions);
+            if (std::find(actions.begin(), actions.end(), a) == actions.end()) {
+                std::cout << m_game.view() << string_of(a) << " is not valid"
+                          << (m_game.is_mirrored() ? " in a mirrored position" : "") << std::endl;
+                ok = false;
+            }
+            m_game.apply(a, states[ply]);
+        }
+
+        set_symmetry(false);
+        m_game.reset();
+        reset(m_game);
+        return ok;
+    }
+
+    /**
+     * Under a memory budget the tree is pruned back within it after each
+     * iteration, across the moves of a game so that the tree kept from
+     * a search to the next one, its recycled children and the history of
+     * the moves are pruned too, and the searches still return valid
+     * actions. Without the budget, the same searches go past it.
+     */
+    bool test_memory_budget() {
+        constexpr size_t budget_mb = 1;
+        constexpr size_t budget = budget_mb << 20;
+        constexpr int n_iterations = 3000;
+        constexpr int n_plies = 6;
+        StateData states[n_plies];
+        std::vector<Action> actions;
+        set_n_iterations(n_iterations);
+        bool ok = true;
+
+        for (size_t mb : { size_t(0), budget_mb }) {
+            m_game.reset();
+            reset(m_game);
+            set_memory_budget(mb);
+
+            for (int ply = 0; ply < n_plies && ok && !m_game.is_lost(); ++ply) {
+                m_game.compute_valid_actions(actions);
+                Action a = ply % 2 == 0 ? best_action() : rand.best_action();
+                if (std::find(actions.begin(), actions.end(), a) == actions.end()) {
+                    std::cout << m_game.view() << string_of(a) << " is not valid" << std::endl;
+                    ok = false;
+                }
+                if (mb && tree_memory() > budget) {
+                    std::cout << "Tree of " << tree_memory() << " bytes over a budget of " << budget << std::endl;
+                    ok = false;
+                }
+                m_game.apply(a, states[ply]);
+            }
+
+            // The high-water mark is taken before pruning, after one expansion
+            if (mb ? peak_memory() > budget + budget / 16 : peak_memory() <= budget) {
+                std::cout << "Peak memory of " << peak_memory() << " bytes "
+                          << (mb ? "over" : "within") << " a budget of " << budget << std::endl;
+                ok = false;
+            }
+        }
+
+        set_memory_budget(0);
+        m_game.reset();
+        reset(m_game);
+        return ok;
+    }
+
+    /**
+     * With an expansion threshold of K, the children of the root are
+     * only expanded on their K-th visit, their visits being counted on
+     * the nodes until then.
+     */
+    bool test_expansion_threshold() {
+        constexpr int threshold = 3;
+        constexpr int n_iterations = 300;
+        m_game.reset();
+        reset(m_game);
+        set_expansion_threshold(threshold);
+        setup_root();
+
+        bool ok = true;
+        for (int i = 0; i < n_iterations && ok; ++i) {
+            run_iteration();
+            for (Edge& e : root().children) {
+                if (e.visits == 0)
+                    continue;
+                const Node& child = *get_node(child_key(e));
+                bool expanded = !child.children.empty();
+                if (expanded != (e.visits >= threshold) || (!expanded && child.visits != e.visits)) {
+                    std::cout << string_of(e.action) << " visited " << e.visits << " times, its node "
+                              << child.visits << " times, " << (expanded ? "expanded" : "not expanded")
+                              << std::endl;
+                    ok = false;
+                }
+            }
+        }
+
+        set_expansion_threshold(1);
+        reset(m_game);
+        return ok;
+    }
+
+    /**
+     * Sequential halving returns a valid action without spending more
+     * than n_iterations, even with fewer of them than root actions, and
+     * stops at the time limit.
+     */
+    bool test_sequential_halving() {
+        constexpr int time_limit_ms = 50;
+        std::vector<Action> actions;
+        set_root_policy(RootPolicy::sequential_halving);
+        bool ok = true;
+
+        for (int n : { 10, 100, 1000 }) {
+            m_game.reset();
+            reset(m_game);
+            set_n_iterations(n);
+            Action a = best_action();
+            m_game.compute_valid_actions(actions);
+            if (std::find(actions.begin(), actions.end(), a) == actions.end() || n_selections() > n) {
+                std::cout << string_of(a) << " chosen after " << n_selections() << " iterations out of "
+                          << n << std::endl;
+                ok = false;
+            }
+        }
+
+        // Rounds sized for far more iterations than fit in the time limit
+        m_game.reset();
+        reset(m_game);
+        set_n_iterations(std::numeric_limits<int>::max());
+        set_time_limit(time_limit_ms);
+        auto start = std::chrono::steady_clock::now();
+        best_action();
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        if (elapsed.count() > 10 * time_limit_ms) {
+            std::cout << "Searched for " << elapsed.count() << "ms with a limit of " << time_limit_ms << "ms"
+                      << std::endl;
+            ok = false;
+        }
+
+        set_time_limit(0);
+        set_root_policy(RootPolicy::ucb);
+        m_game.reset();
+        reset(m_game);
+        return ok;
+    }
+
+    /**
+     * The game-over, exact-result and network exits agree: a move which
+     * wins, or which @losing_net (judging the player to move lost in
+     * every position) takes for a win, is scored below 0.5 by sample(),
+     * for the player to move after it, and above 0.5 by sample_leaf() and
+     * evaluate_child(), for the player who played it.
+     */
+    bool test_exit_agreement(const Nnue::Network& losing_net) {
+        struct Case {
+            const char* name;
+            const char* position;
+            const char* action;
+            const Nnue::Network* net;
+        };
+        const Case cases[] = {
+            { "game over", race_position, "a7a8", nullptr },
+            { "decided race", race_position, "h2h3", nullptr },
+            { "network", start_position, "a2a3", &losing_net },
+        };
+
+        bool ok = true;
+        for (const Case& c : cases) {
+            m_game.set_position(c.position);
+            set_network(c.net);
+            Action a = action_of(c.action);
+            StateData st;
+
+            double playout = sample(a);
+            double child = evaluate_child(a);
+            m_game.apply(a, st);
+            double leaf = sample_leaf();
+            m_game.undo(a);
+
+            std::cout << "  " << c.name << ": playout " << playout << ", leaf " << leaf
+                      << ", child " << child << std::endl;
+            ok &= playout < 0.5 && leaf > 0.5 && child > 0.5;
+        }
+
+        set_network(nullptr);
+        m_game.reset();
+        return ok;
+    }
+
+    /**
+     * Without a minimax weight too, the edges start with the average of
+     * their playouts for the player who takes them, as the rewards which
+     * are backed up to them: in capture_position, c1b2 starts at 1 and
+     * the moves which let black win at 0, and the children are sorted
+     * from the best one for the player to move.
+     */
+    bool test_initial_values() {
+        const Action winning = action_of("c1b2");
+        m_game.set_position(capture_position);
+        reset(m_game);
+        setup_root();
+
+        bool ok = root().children.front().action == winning;
+        for (const Edge& e : root().children) {
+            double expected = e.action == winning ? 1.0 : 0.0;
+            if (e.total != expected) {
+                std::cout << string_of(e.action) << " starts at " << e.total
+                          << " instead of " << expected << std::endl;
+                ok = false;
+            }
+        }
+
+        m_game.reset();
+        reset(m_game);
+        return ok;
+    }
+
+    /**
+     * The edges start with values scored like their minimax values, for
+     * the player who takes them, so that the minimax term steers the
+     * selection toward the only winning move of capture_position even
+     * without any exploration.
+     */
+    bool test_minimax_steering() {
+        constexpr int n_iterations = 100;
+        const Action winning = action_of("c1b2");
+        m_game.set_position(capture_position);
+        reset(m_game);
+        set_minimax_weight(0.5);
+        set_exp_cst(0.0);
+        set_n_iterations(n_iterations);
+
+        bool ok = true;
+        setup_root();
+        for (const Edge& e : root().children) {
+            if (std::abs(e.total - e.minimax) > 0.5) {
+                std::cout << string_of(e.action) << " starts at " << e.total
+                          << " with a minimax value of " << e.minimax << std::endl;
+                ok = false;
+            }
+        }
+
+        Action best = best_action();
+        auto [visits, value] = root_stats(winning);
+        if (best != winning || 2 * visits < n_iterations) {
+            std::cout << string_of(best) << " chosen, " << string_of(winning) << " visited "
+                      << visits << " times out of " << n_iterations << std::endl;
+            ok = false;
+        }
+
+        set_minimax_weight(0.0);
+        m_game.reset();
+        reset(m_game);
+        return ok;
+    }
+
+    /**
+     * Play n_strength_games against random moves, alternating colors,
+     * and return the fraction of them won.
+     */
+    double winrate_against_random() {
+        StateData states[max_depth];
+        set_n_iterations(strength_iterations);
+        int n_wins = 0;
+
+        for (int i = 0; i < n_strength_games; ++i) {
+            m_game.reset();
+            reset(m_game);
+            Color us = i & 1 ? Color::white : Color::black;
+
+            for (StateData* sd = states; !m_game.is_lost() && m_game.pieces(m_game.player_to_move()); ++sd)
+                m_game.apply(m_game.player_to_move() == us ? best_action() : rand.best_action(), *sd);
+
+            n_wins += m_game.player_to_move() != us;
+        }
+
+        m_game.reset();
+        reset(m_game);
+        return double(n_wins) / n_strength_games;
+    }
+
+    /**
+     * The edges expanded with a minimax weight start with the values of
+     * evaluate_child(), although their static evaluations are batched,
+     * along random games.
+     */
+    bool test_batched_child_values() {
+        constexpr int n_games = 20;
+        std::mt19937 eng{ 2022 };
+        StateData states[max_depth];
+        std::vector<Action> actions;
+        set_minimax_weight(1.0);
+        bool ok = true;
+
+        for (int g = 0; g < n_games && ok; ++g) {
+            m_game.reset();
+            for (StateData* sd = states; ok && !m_game.is_lost() && m_game.pieces(m_game.player_to_move()); ++sd) {
+                Node node{ m_game.key(), 0 };
+                expand(node);
+                for (const Edge& e : node.children) {
+                    if (e.minimax != float(evaluate_child(e.action))) {
+                        std::cout << m_game.view() << string_of(e.action) << " starts at " << e.minimax
+                                  << " instead of " << evaluate_child(e.action) << std::endl;
+                        ok = false;
+                    }
+                }
+
+                m_game.compute_valid_actions(actions);
+                m_game.apply(actions[eng() % actions.size()], *sd);
+            }
+        }
+
+        set_minimax_weight(0.0);
+        m_game.reset();
+        return ok;
+    }
+
     void expand_all_child()
     {
         setup_root();
@@ -180,9 +742,14 @@ constexpr auto n_iterations = 300;
 constexpr auto exp_cst = 1.4;
 constexpr auto n_initial_samples = 1;
 
+/**
+ * Check the conventions of the rewards, or explore the search
+ * interactively when run with --interactive.
+ */
 int main(int argc, char* argv[])
 {
     Game::init();
+    Random::set_seed(2022);
     //StateData states[max_depth + 1], *sd = &states[0];
 
     Game game;
@@ -193,6 +760,65 @@ int main(int argc, char* argv[])
     mcts.set_n_init_samples(n_initial_samples);
     mcts.set_n_iterations(n_iterations);
 
+    if (argc < 2 || std::string_view(argv[1]) != "--interactive") {
+        bool ok = mcts.test_setuproot();
+        std::cout << "Setup root: " << (ok ? "OK" : "FAILED") << std::endl;
+
+        Tablebase::generate(tb_max_pieces, tb_dir);
+        Tablebase tb;
+        bool tb_ok = tb.load(tb_dir) && mcts.test_tablebase_rewards(tb);
+        std::cout << "Tablebase rewards: " << (tb_ok ? "OK" : "FAILED") << std::endl;
+        std::filesystem::remove_all(tb_dir);
+
+        // A network favouring the player to move in every position
+        write_constant_network(nnue_fp, 2.0);
+        Nnue::Network net;
+        bool net_ok = net.load(nnue_fp) && mcts.test_network_rewards(net);
+        std::cout << "Network rewards: " << (net_ok ? "OK" : "FAILED") << std::endl;
+
+        write_constant_network(nnue_fp, -2.0);
+        Nnue::Network losing_net;
+        bool exits_ok = losing_net.load(nnue_fp) && mcts.test_exit_agreement(losing_net);
+        std::cout << "Exits agree: " << (exits_ok ? "OK" : "FAILED") << std::endl;
+        std::filesystem::remove(nnue_fp);
+
+        bool transpositions_ok = mcts.test_transposition_stats();
+        std::cout << "Transposition stats: " << (transpositions_ok ? "OK" : "FAILED") << std::endl;
+        mcts.set_exp_cst(exp_cst);
+
+        bool symmetry_ok = mcts.test_symmetry();
+        std::cout << "Symmetry: " << (symmetry_ok ? "OK" : "FAILED") << std::endl;
+
+        bool budget_ok = mcts.test_memory_budget();
+        std::cout << "Memory budget: " << (budget_ok ? "OK" : "FAILED") << std::endl;
+
+        bool threshold_ok = mcts.test_expansion_threshold();
+        std::cout << "Expansion threshold: " << (threshold_ok ? "OK" : "FAILED") << std::endl;
+
+        bool halving_ok = mcts.test_sequential_halving();
+        std::cout << "Sequential halving: " << (halving_ok ? "OK" : "FAILED") << std::endl;
+        mcts.set_n_iterations(n_iterations);
+
+        bool init_ok = mcts.test_initial_values();
+        std::cout << "Initial values: " << (init_ok ? "OK" : "FAILED") << std::endl;
+
+        bool minimax_ok = mcts.test_minimax_steering();
+        std::cout << "Minimax steering: " << (minimax_ok ? "OK" : "FAILED") << std::endl;
+        mcts.set_exp_cst(exp_cst);
+        mcts.set_n_iterations(n_iterations);
+
+        bool batch_ok = mcts.test_batched_child_values();
+        std::cout << "Batched child values: " << (batch_ok ? "OK" : "FAILED") << std::endl;
+
+        double winrate = mcts.winrate_against_random();
+        bool strength_ok = winrate >= min_winrate;
+        std::cout << "Winrate against random moves: " << 100.0 * winrate << "% "
+                  << (strength_ok ? "OK" : "FAILED") << std::endl;
+        mcts.set_n_iterations(n_iterations);
+
+        return ok && tb_ok && net_ok && exits_ok && transpositions_ok && symmetry_ok && budget_ok && threshold_ok && halving_ok && init_ok && minimax_ok && batch_ok && strength_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     mcts.test_setuproot();
 
     game.reset();
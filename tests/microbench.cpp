@@ -0,0 +1,317 @@
+#include "types.h"
+#include "game.h"
+#include "eval.h"
+#include "mcts.h"
+#include "random.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+constexpr int default_n_repetitions = 20;
+constexpr int default_n_warmup = 3;
+constexpr int n_positions = 32;
+constexpr int n_tree_iterations = 2000;
+constexpr int n_table_keys = 1 << 16;
+
+const char* usage = R"(Usage: benchmark_micro [options]
+
+Time the hot paths of the engine on a fixed set of positions. Each
+benchmark is run a few times to warm up, then timed over several
+repetitions. The results are written as JSON, with the mean, median,
+standard deviation and extrema of the time per operation.
+
+Options:
+    --reps N        timed repetitions of each benchmark (20)
+    --warmup N      untimed repetitions before them (3)
+    --filter TEXT   only run the benchmarks whose name contains TEXT
+    --output FILE   write the JSON there instead of the standard output
+)";
+
+struct Position {
+    Bitboard white, black;
+    Color side;
+};
+
+/**
+ * Positions reached by seeded random play, from the opening to
+ * the endgame, none of them being over.
+ */
+std::vector<Position> make_positions(Game& game) {
+    std::mt19937 eng{ 2022 };
+    StateData states[max_depth];
+    std::vector<Action> actions;
+    std::vector<Position> ret;
+
+    while (ret.size() < n_positions) {
+        const int n_plies = 2 * int(ret.size()) + 4;
+        game.reset();
+        int ply = 0;
+        for (; ply < n_plies && !game.is_lost(); ++ply) {
+            game.compute_valid_actions(actions);
+            game.apply(actions[eng() % actions.size()], states[ply]);
+        }
+        if (ply == n_plies && !game.is_lost() && game.pieces(game.player_to_move()))
+            ret.push_back({ game.pieces(Color::white), game.pieces(Color::black), game.player_to_move() });
+    }
+    return ret;
+}
+
+/**
+ * Gives access to the internals of the search.
+ */
+class MctsBench : public Mcts {
+public:
+    using Mcts::Mcts;
+    using Mcts::setup_root;
+    using Mcts::select;
+    using Mcts::backpropagate;
+    using Mcts::expand;
+    using Mcts::get_node;
+};
+
+struct Result {
+    std::string name;
+    long ops;                   // operations per repetition
+    std::vector<double> ns;     // time per operation of each repetition
+};
+
+class Runner {
+public:
+    Runner(int n_reps, int n_warmup, std::string filter)
+        : n_reps{ n_reps }, n_warmup{ n_warmup }, filter{ std::move(filter) } {}
+
+    /**
+     * Time @n_reps calls of @f, which performs @ops operations
+     * and returns a value folded into the checksum so that it
+     * cannot be optimized away. @setup is called before each of
+     * them, out of the timings.
+     */
+    template<typename F, typename S = void(*)()>
+    void run(const std::string& name, long ops, F f, S setup = [] {}) {
+        if (name.find(filter) == std::string::npos)
+            return;
+
+        for (int i = 0; i < n_warmup; ++i) {
+            setup();
+            checksum += f();
+        }
+
+        Result& r = results.emplace_back(Result{ name, ops, {} });
+        for (int i = 0; i < n_reps; ++i) {
+            setup();
+            auto start = std::chrono::steady_clock::now();
+            checksum += f();
+            auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            r.ns.push_back(ns / ops);
+        }
+
+        std::cerr << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(12) << median(r.ns) << " ns/op" << std::endl;
+    }
+
+    void write_json(std::ostream& out) const {
+        out << std::fixed << "{\n"
+            << "  \"compiler\": \"" << __VERSION__ << "\",\n"
+            << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n"
+            << "  \"repetitions\": " << n_reps << ",\n"
+            << "  \"warmup\": " << n_warmup << ",\n"
+            << "  \"checksum\": " << std::setprecision(6) << checksum << ",\n"
+            << "  \"benchmarks\": [";
+
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            const double mean = std::accumulate(r.ns.begin(), r.ns.end(), 0.0) / r.ns.size();
+            double var = 0.0;
+            for (double x : r.ns)
+                var += (x - mean) * (x - mean);
+            const double stddev = r.ns.size() > 1 ? std::sqrt(var / (r.ns.size() - 1)) : 0.0;
+
+            out << (i ? "," : "") << "\n    {"
+                << "\"name\": \"" << r.name << "\", "
+                << "\"ops\": " << r.ops << ", "
+                << std::setprecision(1)
+                << "\"mean_ns\": " << mean << ", "
+                << "\"median_ns\": " << median(r.ns) << ", "
+                << "\"stddev_ns\": " << stddev << ", "
+                << "\"min_ns\": " << *std::min_element(r.ns.begin(), r.ns.end()) << ", "
+                << "\"max_ns\": " << *std::max_element(r.ns.begin(), r.ns.end()) << ", "
+                << std::setprecision(0)
+                << "\"ops_per_s\": " << 1e9 / median(r.ns) << "}";
+        }
+        out << "\n  ]\n}" << std::endl;
+    }
+
+private:
+    static double median(std::vector<double> v) {
+        std::sort(v.begin(), v.end());
+        return v.size() % 2 ? v[v.size() / 2] : (v[v.size() / 2 - 1] + v[v.size() / 2]) / 2;
+    }
+
+    int n_reps, n_warmup;
+    std::string filter;
+    std::vector<Result> results;
+    double checksum = 0.0;
+};
+
+int main(int argc, char *argv[]) {
+    int n_reps = default_n_repetitions;
+    int n_warmup = default_n_warmup;
+    std::string filter, output_fp;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << usage;
+            return EXIT_FAILURE;
+        }
+        if (arg == "--reps")         n_reps = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--warmup")  n_warmup = std::stoi(argv[++i]);
+        else if (arg == "--filter")  filter = argv[++i];
+        else if (arg == "--output")  output_fp = argv[++i];
+        else {
+            std::cerr << usage;
+            return EXIT_FAILURE;
+        }
+    }
+
+    Random::set_seed(2022);
+    Game::init();
+    Game game;
+    StateData states[max_depth];
+    std::vector<Action> actions;
+    const auto positions = make_positions(game);
+    Runner runner{ n_reps, n_warmup, filter };
+
+    std::vector<std::vector<Action>> position_actions;
+    long n_actions = 0;
+    for (const auto& p : positions) {
+        game.set_position(p.white, p.black, p.side);
+        game.compute_valid_actions(position_actions.emplace_back());
+        n_actions += long(position_actions.back().size());
+    }
+
+    // The position is set once for many operations, so that
+    // set_position() does not weigh on the timings
+    runner.run("compute_valid_actions", 100 * n_positions, [&] {
+        size_t sum = 0;
+        for (const auto& p : positions) {
+            game.set_position(p.white, p.black, p.side);
+            for (int r = 0; r < 100; ++r) {
+                game.compute_valid_actions(actions);
+                sum += actions.size();
+            }
+        }
+        return double(sum);
+    });
+
+    runner.run("apply_undo", 100 * n_actions, [&] {
+        Key sum = 0;
+        for (size_t i = 0; i < positions.size(); ++i) {
+            const auto& p = positions[i];
+            game.set_position(p.white, p.black, p.side);
+            for (int r = 0; r < 100; ++r) {
+                for (Action a : position_actions[i]) {
+                    game.apply(a, states[0]);
+                    sum ^= game.get_sd()->key;
+                    game.undo(a);
+                }
+            }
+        }
+        return double(sum & 0xffff);
+    });
+
+    runner.run("static_eval", 1000 * n_positions, [&] {
+        double sum = 0.0;
+        for (const auto& p : positions) {
+            game.set_position(p.white, p.black, p.side);
+            for (int r = 0; r < 1000; ++r)
+                sum += static_eval(game);
+        }
+        return sum;
+    });
+
+    MctsBench mcts{ game };
+
+    runner.run("playout", 10 * n_positions, [&] {
+        double sum = 0.0;
+        for (int r = 0; r < 10; ++r) {
+            for (size_t i = 0; i < positions.size(); ++i) {
+                const auto& p = positions[i];
+                game.set_position(p.white, p.black, p.side);
+                sum += mcts.sample(position_actions[i][r % position_actions[i].size()]);
+            }
+        }
+        return sum;
+    });
+
+    // Expansions of a fresh node, with one initial playout per child
+    runner.run("expand", n_positions, [&] {
+        double sum = 0.0;
+        for (const auto& p : positions) {
+            game.set_position(p.white, p.black, p.side);
+            Node node{ game.get_sd()->key, 0 };
+            mcts.expand(node);
+            sum += node.children.size();
+        }
+        return sum;
+    });
+
+    // Descents and backups through a tree grown from the middlegame position
+    const Position& middle = positions[n_positions / 2];
+    game.set_position(middle.white, middle.black, middle.side);
+    mcts.reset(game);
+    mcts.set_n_iterations(n_tree_iterations);
+    mcts.best_action();
+    mcts.setup_root();
+
+    runner.run("select_backpropagate", 10000, [&] {
+        for (int r = 0; r < 10000; ++r) {
+            mcts.select();
+            mcts.backpropagate(0.5);
+        }
+        return 0.0;
+    });
+
+    std::mt19937_64 eng{ 2022 };
+    std::vector<Key> keys(n_table_keys);
+    for (auto& k : keys)
+        k = eng();
+
+    runner.run("ttable_insert", n_table_keys, [&] {
+        double sum = 0.0;
+        for (Key k : keys)
+            sum += mcts.get_node(k)->visits;
+        return sum;
+    }, [&] { mcts.reset(game); });
+
+    runner.run("ttable_lookup", n_table_keys, [&] {
+        double sum = 0.0;
+        for (size_t i = 0; i < keys.size(); ++i)
+            sum += mcts.get_node(keys[(i * 7919) % keys.size()])->visits;
+        return sum;
+    });
+
+    if (output_fp.empty()) {
+        runner.write_json(std::cout);
+    }
+    else {
+        std::ofstream ofs{ output_fp };
+        runner.write_json(ofs);
+        if (!ofs) {
+            std::cerr << "Failed to write " << output_fp << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,167 @@
+#include "types.h"
+#include "game.h"
+#include "nnue.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+
+constexpr int default_n_games = 200;
+
+const std::filesystem::path fp = std::filesystem::temp_directory_path() / "bt_nnue_test.nnue";
+
+/**
+ * Random weights, written in the layout documented in nnue.h.
+ */
+struct Weights {
+    int16_t biases1[Nnue::n_hidden];
+    int16_t weights1[Nnue::n_inputs][Nnue::n_hidden];
+    int32_t biases2[Nnue::n_l2];
+    int8_t weights2[Nnue::n_l2][2 * Nnue::n_hidden];
+    int32_t bias3;
+    int8_t weights3[Nnue::n_l2];
+
+    explicit Weights(std::mt19937& eng) {
+        std::uniform_int_distribution<> small(-48, 48), large(-4000, 4000);
+        for (auto& b : biases1) b = small(eng);
+        for (auto& row : weights1) for (auto& w : row) w = small(eng);
+        for (auto& b : biases2) b = large(eng);
+        for (auto& row : weights2) for (auto& w : row) w = small(eng);
+        bias3 = large(eng);
+        for (auto& w : weights3) w = small(eng);
+    }
+
+    void write(const std::filesystem::path& path, bool truncate = false) const {
+        const uint32_t header[] = { 0x4E4E5442, 1, Nnue::n_inputs, Nnue::n_hidden, Nnue::n_l2 };
+        std::ofstream ofs{ path, std::ios::binary };
+        ofs.write(reinterpret_cast<const char*>(header), sizeof(header));
+        ofs.write(reinterpret_cast<const char*>(biases1), sizeof(biases1));
+        ofs.write(reinterpret_cast<const char*>(weights1), sizeof(weights1));
+        ofs.write(reinterpret_cast<const char*>(biases2), sizeof(biases2));
+        ofs.write(reinterpret_cast<const char*>(weights2), sizeof(weights2));
+        ofs.write(reinterpret_cast<const char*>(&bias3), sizeof(bias3));
+        ofs.write(reinterpret_cast<const char*>(weights3), sizeof(weights3) - truncate);
+    }
+
+    /**
+     * Output of the network computed from scratch, without any
+     * accumulator.
+     */
+    int logit(const Game& game) const {
+        int hidden[Ncolors][Nnue::n_hidden];
+        for (Color p : { Color::white, Color::black }) {
+            for (int i = 0; i < Nnue::n_hidden; ++i) {
+                int sum = biases1[i];
+                for (Square sq = Square::a1; sq < Square::Nb; ++sq) {
+                    Piece pc = game.piece_at(sq);
+                    if (pc == Piece::none)
+                        continue;
+                    int s = to_integral(relative(p, sq));
+                    sum += weights1[(color_of(pc) == p ? 0 : Nsquares) + s][i];
+                }
+                hidden[to_integral(p)][i] = std::clamp(sum, 0, 127);
+            }
+        }
+
+        Color us = game.player_to_move();
+        int out = bias3;
+        for (int j = 0; j < Nnue::n_l2; ++j) {
+            int sum = biases2[j];
+            for (int i = 0; i < Nnue::n_hidden; ++i) {
+                sum += weights2[j][i] * hidden[to_integral(us)][i];
+                sum += weights2[j][Nnue::n_hidden + i] * hidden[to_integral(opposite_of(us))][i];
+            }
+            out += weights3[j] * std::clamp(sum >> 6, 0, 127);
+        }
+        return out;
+    }
+};
+
+/**
+ * Evaluate the positions of random games at random plies, so that
+ * the accumulators are brought up to date over several moves at once.
+ */
+bool test_incremental(const Nnue::Network& network, const Weights& weights, int n_games) {
+    Game game;
+    StateData states[max_depth];
+    std::vector<Action> actions;
+    Action played[max_depth];
+    std::mt19937 eng{ 2022 };
+    long n_positions = 0;
+
+    auto check = [&](const char* when, int ply) {
+        if (eng() % 3)
+            return true;
+        ++n_positions;
+        int logit = network.evaluate_logit(game);
+        if (logit == weights.logit(game))
+            return true;
+        std::cout << game.view() << '\n' << "Logit " << logit << " (expected " << weights.logit(game)
+                  << ") after " << when << " at ply " << ply << std::endl;
+        return false;
+    };
+
+    for (int i = 0; i < n_games; ++i) {
+        game.reset();
+        int ply = 0;
+
+        while (!game.is_lost()) {
+            game.compute_valid_actions(actions);
+            if (actions.empty())
+                break;
+            std::uniform_int_distribution<> dist(0, actions.size() - 1);
+            played[ply] = actions[dist(eng)];
+            game.apply(played[ply], states[ply]);
+            ++ply;
+
+            if (!check("apply", ply))
+                return false;
+        }
+
+        while (ply > 0) {
+            game.undo(played[--ply]);
+            if (!check("undo", ply))
+                return false;
+        }
+    }
+
+    std::cout << "Evaluated " << n_positions << " positions" << std::endl;
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    Game::init();
+    std::mt19937 eng{ 42 };
+    Weights weights{ eng };
+    Nnue::Network network;
+
+    int n_games = argc > 1 ? std::stoi(argv[1]) : default_n_games;
+
+    weights.write(fp, true);
+    bool ok = !network.load(fp);
+    std::cout << "Truncated file rejected: " << (ok ? "OK" : "FAILED") << std::endl;
+
+    weights.write(fp);
+    if (!network.load(fp)) {
+        std::cout << "Failed to load the network" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::filesystem::remove(fp);
+
+    bool incremental_ok = test_incremental(network, weights, n_games);
+    std::cout << "Incremental evaluation: " << (incremental_ok ? "OK" : "FAILED") << std::endl;
+
+    // The accumulators of the previous weights must not be reused
+    Weights other{ eng };
+    other.write(fp);
+    bool reload_ok = network.load(fp) && test_incremental(network, other, n_games / 10 + 1);
+    std::filesystem::remove(fp);
+    std::cout << "Reloaded weights: " << (reload_ok ? "OK" : "FAILED") << std::endl;
+
+    return ok && incremental_ok && reload_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,84 @@
+#include "types.h"
+#include "game.h"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+
+constexpr int default_n_games = 200;
+
+constexpr const char* start_position = "bbbbbbbb/bbbbbbbb/8/8/8/8/wwwwwwww/wwwwwwww w";
+
+constexpr const char* invalid[] = {
+    "",
+    "bbbbbbbb/bbbbbbbb/8/8/8/8/wwwwwwww/wwwwwwww",      // no player to move
+    "bbbbbbbb/bbbbbbbb/8/8/8/8/wwwwwwww/wwwwwwww x",
+    "bbbbbbbb/bbbbbbbb/8/8/8/8/wwwwwwww w",             // seven rows
+    "bbbbbbbb/bbbbbbbb/8/8/8/8/8/wwwwwwww/wwwwwwww w",  // nine rows
+    "bbbbbbbbb/bbbbbbbb/8/8/8/8/wwwwwwww/wwwwwwww w",   // nine columns
+    "bbbbbbb/bbbbbbbb/8/8/8/8/wwwwwwww/wwwwwwww w",     // seven columns
+    "bbbbbbbb/bbbbbbbb/8/8/8/8/wwwwwwww/wwwwwwww/ w",
+    "bbbbbbbb/bbbbbbbb/9/8/8/8/wwwwwwww/wwwwwwww w",
+    "bbbbbbbb/bbbbbbbb/8/8/8/8/wwwwwwww/wwwwwwwW w",
+    "bbbbbbbb/bbbbbbbb/8/8/8/8/wwwwwwww/wwwwwwww w b",
+};
+
+/**
+ * Check the notation of the start position, that invalid notations
+ * are rejected, and that the positions of random games are the same
+ * after writing and reading them back.
+ */
+int main(int argc, char *argv[]) {
+    Game::init();
+    Game game, copy;
+    StateData states[max_depth];
+    std::vector<Action> actions;
+    std::mt19937 eng{ 2022 };
+    int n_failures = 0;
+
+    if (game.notation() != start_position) {
+        std::cout << "Start position written as " << game.notation() << std::endl;
+        ++n_failures;
+    }
+    if (!copy.set_position(start_position) || copy.key() != game.key()) {
+        std::cout << "Start position not read back" << std::endl;
+        ++n_failures;
+    }
+
+    for (const char* notation : invalid) {
+        copy.reset();
+        if (copy.set_position(notation) || copy.notation() != start_position) {
+            std::cout << "Invalid notation accepted: \"" << notation << "\"" << std::endl;
+            ++n_failures;
+        }
+    }
+
+    const int n_games = argc > 1 ? std::stoi(argv[1]) : default_n_games;
+    long n_positions = 0;
+    for (int g = 0; g < n_games; ++g) {
+        game.reset();
+        for (int ply = 0; !game.is_lost() && game.pieces(game.player_to_move()); ++ply) {
+            const std::string notation = game.notation();
+            if (!copy.set_position(notation)
+                || copy.pieces(Color::white) != game.pieces(Color::white)
+                || copy.pieces(Color::black) != game.pieces(Color::black)
+                || copy.player_to_move() != game.player_to_move()
+                || copy.key() != game.key()
+                || copy.notation() != notation) {
+                std::cout << "Game " << g << ", ply " << ply << ": " << notation
+                          << " not read back" << game.view() << std::endl;
+                ++n_failures;
+                break;
+            }
+            ++n_positions;
+
+            game.compute_valid_actions(actions);
+            game.apply(actions[eng() % actions.size()], states[ply]);
+        }
+    }
+
+    std::cout << n_positions << " positions, " << n_failures << " failure(s)" << std::endl;
+    return n_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
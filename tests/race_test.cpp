@@ -0,0 +1,125 @@
+#include "types.h"
+#include "game.h"
+#include "race.h"
+#include "solver.h"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+
+constexpr int default_n_games = 2000;
+
+/**
+ * A decided race stays decided, one ply closer to its end,
+ * whatever is played next.
+ */
+bool check_consistent(Game& game, Color c, const RaceResult& result) {
+    Color them = opposite_of(c);
+    StateData sd;
+    std::vector<Action> actions;
+
+    if (game.player_to_move() == c)
+        actions = { result.action };
+    else
+        game.compute_valid_actions(actions);
+
+    for (Action a : actions) {
+        game.apply(a, sd);
+        // Capturing the last piece of the opponent also wins
+        bool lost = game.is_lost() || !game.pieces(them);
+        RaceResult next = race(c, game.pieces(c), game.pieces(them), game.pieces(c), game.player_to_move() == c);
+        game.undo(a);
+
+        bool ok = lost ? game.player_to_move() == c
+                       : next.plies > 0 && next.plies <= result.plies - 1;
+        if (!ok) {
+            std::cout << game.view(a) << '\n' << (c == Color::white ? "WHITE" : "BLACK")
+                      << " race in " << result.plies << " plies, then " << next.plies << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Check the decided races of the position of @game, against
+ * the solver for the smaller ones.
+ */
+bool check_races(Game& game, Solver& solver, long& n_races, long& n_solved) {
+    for (Color c : { Color::white, Color::black }) {
+        RaceResult result = race(game, c);
+        if (!result.plies)
+            continue;
+        ++n_races;
+
+        if (!check_consistent(game, c, result))
+            return false;
+
+        if (count(~game.no_pieces()) > 12)
+            continue;
+
+        Proof expected = c == game.player_to_move() ? Proof::win : Proof::loss;
+        SolverResult proof = solver.solve();
+        n_solved += proof.proof != Proof::unknown;
+        if (proof.proof != Proof::unknown && proof.proof != expected) {
+            std::cout << game.view() << '\n' << "Solver disagrees with the race of "
+                      << (c == Color::white ? "WHITE" : "BLACK") << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    Game::init();
+    Game game;
+    Solver solver(game);
+    solver.set_node_limit(100000);
+    StateData states[max_depth];
+    std::vector<Action> actions;
+    std::mt19937 eng{ 2022 };
+
+    int n_games = argc > 1 ? std::stoi(argv[1]) : default_n_games;
+    long n_positions = 0, n_races = 0, n_solved = 0;
+
+    for (int i = 0; i < n_games; ++i) {
+        game.reset();
+        int ply = 0;
+
+        while (!game.is_lost()) {
+            game.compute_valid_actions(actions);
+            if (actions.empty())
+                break;
+            std::uniform_int_distribution<> dist(0, actions.size() - 1);
+            game.apply(actions[dist(eng)], states[ply++]);
+            ++n_positions;
+
+            if (game.is_lost())
+                break;
+
+            if (!check_races(game, solver, n_races, n_solved))
+                return EXIT_FAILURE;
+        }
+    }
+
+    // Endgames with a few pieces on each side
+    for (int i = 0; i < n_games; ++i) {
+        Bitboard white = 0, black = 0;
+        int n_white = 1 + eng() % 5, n_black = 1 + eng() % 5;
+        while (count(white) < n_white)
+            white |= (Bitboard(1) << (eng() % 64)) & ~BB::Row8;
+        while (count(black) < n_black)
+            black |= (Bitboard(1) << (eng() % 64)) & ~(BB::Row1 | white);
+
+        game.set_position(white, black, eng() & 1 ? Color::white : Color::black);
+        ++n_positions;
+        if (!check_races(game, solver, n_races, n_solved))
+            return EXIT_FAILURE;
+    }
+
+    std::cout << n_races << " decided races in " << n_positions << " positions ("
+              << n_solved << " confirmed by the solver): OK" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,93 @@
+#include "types.h"
+#include "game.h"
+#include "mcts.h"
+#include "epsilonGreedy.h"
+#include "random.h"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+constexpr int n_positions = 8;
+constexpr int n_mcts_iterations = 2000;
+constexpr int n_agent_iterations = 2000;
+
+struct Search {
+    Action action;
+    std::vector<std::pair<Action, int>> visits;
+    int rollouts;
+
+    bool operator==(const Search&) const = default;
+};
+
+Search search_mcts(Game& game, uint64_t stream) {
+    Random::set_thread_stream(stream);
+    Mcts mcts(game);
+    mcts.set_n_iterations(n_mcts_iterations);
+    Search s;
+    s.action = mcts.best_action();
+    mcts.root_visits(s.visits);
+    s.rollouts = mcts.n_rollouts();
+    return s;
+}
+
+Action search_agent(Game& game, int n_threads) {
+    Random::set_thread_stream(0);
+    Agent agent(game);
+    agent.set_n_iterations(n_agent_iterations);
+    agent.set_n_threads(n_threads);
+    return agent.best_action();
+}
+
+/**
+ * Search positions reached by random play twice with the same seed
+ * and stream, and check that the searches are the same, then once
+ * with another stream, which should give other visits.
+ */
+int main(int argc, char *argv[]) {
+    Random::set_seed(argc > 1 ? std::stoull(argv[1]) : 2022);
+    Game::init();
+    Game game;
+    StateData states[max_depth];
+    std::vector<Action> actions;
+    std::mt19937 eng{ 2022 };
+    int n_failures = 0;
+    int n_same_visits = 0;
+
+    for (int p = 0; p < n_positions; ++p) {
+        game.reset();
+        for (int ply = 0; ply < 4 * p && !game.is_lost(); ++ply) {
+            game.compute_valid_actions(actions);
+            game.apply(actions[eng() % actions.size()], states[ply]);
+        }
+        if (game.is_lost())
+            continue;
+
+        Search first = search_mcts(game, 0);
+        if (search_mcts(game, 0) != first) {
+            std::cout << "Position " << p << ": Mcts searches with the same stream differ" << std::endl;
+            ++n_failures;
+        }
+        n_same_visits += search_mcts(game, 1).visits == first.visits;
+
+        for (int n_threads : { 1, 2 }) {
+            Action a = search_agent(game, n_threads);
+            if (search_agent(game, n_threads) != a) {
+                std::cout << "Position " << p << ": Agent searches on " << n_threads
+                          << " thread(s) with the same stream differ" << std::endl;
+                ++n_failures;
+            }
+        }
+    }
+
+    if (n_same_visits == n_positions) {
+        std::cout << "The searches with another stream are the same" << std::endl;
+        ++n_failures;
+    }
+
+    std::cout << (n_failures ? "FAILED" : "OK") << std::endl;
+    return n_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
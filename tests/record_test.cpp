@@ -0,0 +1,95 @@
+#include "types.h"
+#include "record.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+constexpr int default_n_records = 10000;
+constexpr size_t max_file_bytes = 64 << 10;
+
+namespace fs = std::filesystem;
+
+/**
+ * Write random records through a small buffer and with a small file
+ * size limit, then check that reading the rotated files back gives
+ * the same records in the same order.
+ */
+int main(int argc, char *argv[]) {
+    const int n_records = argc > 1 ? std::stoi(argv[1]) : default_n_records;
+    const fs::path dir = fs::temp_directory_path() / "bt_record_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    std::mt19937_64 eng{ 2022 };
+    std::vector<Records::Record> written(n_records);
+    for (auto& r : written) {
+        r.white = eng();
+        r.black = eng() & ~r.white;
+        r.side = eng() & 1 ? Color::black : Color::white;
+        r.result = eng() & 1 ? 1 : -1;
+        r.ply = uint16_t(eng() % 200);
+        std::vector<std::pair<Action, int>> visits(eng() % 49);
+        for (auto& [a, n] : visits)
+            a = Action(eng() & 0xffff), n = int(eng() % 100000);
+        r.set_visits(visits);
+    }
+
+    int n_files;
+    {
+        Records::Writer writer{ dir / "test", max_file_bytes, 4096 };
+        for (const auto& r : written) {
+            if (!writer.write(r)) {
+                std::cout << "Write failed" << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        n_files = writer.n_files();
+    }
+
+    if (n_files < 2) {
+        std::cout << "Expected the records to be split over several files, got " << n_files << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Records::Record> read;
+    for (int i = 0; i < n_files; ++i) {
+        std::ostringstream name;
+        name << "test-" << std::setw(5) << std::setfill('0') << i << ".bin";
+        fs::path fp = dir / name.str();
+        if (fs::file_size(fp) > max_file_bytes + Records::fixed_size + 4 * 255) {
+            std::cout << fp << " is over the size limit" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        Records::Reader reader{ fp };
+        if (!reader.ok())
+            return EXIT_FAILURE;
+        for (Records::Record r; reader.next(r); )
+            read.push_back(r);
+    }
+
+    if (read != written) {
+        std::cout << "Read " << read.size() << " records, wrote " << written.size() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Counts above 65535 are scaled down, the largest one to 65535
+    bool scaled = std::any_of(written.begin(), written.end(), [](const auto& r) {
+        return std::any_of(r.visits.begin(), r.visits.end(), [](auto v) { return v.second == UINT16_MAX; });
+    });
+    if (!scaled) {
+        std::cout << "No visit count was scaled down" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    fs::remove_all(dir);
+    std::cout << n_records << " records in " << n_files << " files\nOK" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -1,6 +1,7 @@
 #include "types.h"
 #include "game.h"
 #include "agentRandom.h"
+#include "eval.h"
 #include "mcts.h"
 
 #include <chrono>
@@ -11,6 +12,8 @@
 
 
 constexpr int default_n_playouts = 10000;
+constexpr int n_eval_positions = 1 << 16;
+constexpr int n_eval_rounds = 20;
 
 void playout_agent_random(Game& game, AgentRandom& agent) {
   StateData states[max_depth], *sd = &states[0];
@@ -21,6 +24,56 @@ void playout_agent_random(Game& game, AgentRandom& agent) {
   }
 }
 
+/**
+ * Throughput of the static evaluation, one game at a time and
+ * in batches of positions.
+ */
+void benchmark_eval(Game& game, AgentRandom& agent) {
+    StateData states[max_depth];
+    std::vector<Bitboard> white, black;
+    std::vector<Color> side;
+
+    while (white.size() < n_eval_positions) {
+        game.reset();
+        for (StateData* sd = &states[0]; !game.is_lost() && white.size() < n_eval_positions; ++sd) {
+            game.apply(agent.sample(), *sd);
+            white.push_back(game.pieces(Color::white));
+            black.push_back(game.pieces(Color::black));
+            side.push_back(game.player_to_move());
+        }
+    }
+
+    std::vector<double> out(n_eval_positions);
+    double sum = 0;
+
+    auto report = [&](const char* name, auto f) {
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < n_eval_rounds; ++r)
+            f();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        for (double v : out)
+            sum += v;
+
+        std::cout << ' ' << name << ": " << std::setprecision(3)
+                  << n_eval_rounds * n_eval_positions / seconds / 1e6 << "M positions/s" << std::endl;
+    };
+
+    std::cout << "\n    Static evaluation:" << std::endl;
+    report("static_eval", [&] {
+        for (int i = 0; i < n_eval_positions; ++i) {
+            game.set_position(white[i], black[i], side[i]);
+            out[i] = static_eval(game);
+        }
+    });
+    report("static_eval_batch_scalar", [&] {
+        static_eval_batch_scalar(n_eval_positions, white.data(), black.data(), side.data(), out.data());
+    });
+    report("static_eval_batch", [&] {
+        static_eval_batch(n_eval_positions, white.data(), black.data(), side.data(), out.data());
+    });
+    std::cout << " (checksum " << sum << ")" << std::endl;
+}
+
 int main(int argc, char *argv[]) {
     Game::init();
     Game game{};
@@ -63,4 +116,6 @@ int main(int argc, char *argv[]) {
               << std::chrono::duration_cast<std::chrono::milliseconds>(
                 std::chrono::steady_clock::now() - start).count()
               << "ms." << std::endl;
+
+    benchmark_eval(game, agent);
 }
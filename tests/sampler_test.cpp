@@ -0,0 +1,108 @@
+#include "types.h"
+#include "game.h"
+#include "mcts.h"
+#include "sampler.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+
+constexpr int default_n_positions = 20;
+constexpr int n_reference_samples = 400;
+constexpr int n_repeats = 10;
+constexpr int budgets[] = { 4, 10, 20 };
+
+struct Score {
+    long playouts = 0;
+    int hits = 0;
+    double regret = 0.0;
+    int n = 0;
+};
+
+/**
+ * Pick the best candidate of @stats by average reward and score it
+ * against the reference values @reference.
+ */
+void score(const std::vector<SampleStats>& stats, const std::vector<double>& reference, int spent, Score& s) {
+    auto chosen = std::max_element(stats.begin(), stats.end(), [](const auto& a, const auto& b) {
+        return a.mean() < b.mean();
+    }) - stats.begin();
+    double best = *std::max_element(reference.begin(), reference.end());
+
+    s.playouts += spent;
+    s.hits += reference[chosen] == best;
+    s.regret += best - reference[chosen];
+    ++s.n;
+}
+
+/**
+ * Decision accuracy of the adaptive sampler against fixed sample counts
+ * with the same budget, the reference being a large fixed-sample run.
+ */
+int main(int argc, char *argv[]) {
+    Game::init();
+    Game game;
+    Mcts mcts(game);
+    StateData states[max_depth];
+    std::vector<Action> actions;
+    std::mt19937 eng{ 2022 };
+
+    int n_positions = argc > 1 ? std::stoi(argv[1]) : default_n_positions;
+    Score fixed[std::size(budgets)], adaptive[std::size(budgets)];
+
+    for (int p = 0; p < n_positions; ++p) {
+        // A middle game position reached by random moves
+        game.reset();
+        int n_plies = 10 + eng() % 30;
+        for (int ply = 0; ply < n_plies && !game.is_lost(); ++ply) {
+            game.compute_valid_actions(actions);
+            game.apply(actions[eng() % actions.size()], states[ply]);
+        }
+        if (game.is_lost()) {
+            --p;
+            continue;
+        }
+
+        game.compute_valid_actions(actions);
+        std::vector<double> reference(actions.size());
+        for (size_t i = 0; i < actions.size(); ++i)
+            reference[i] = mcts.sample(actions[i], n_reference_samples) / n_reference_samples;
+
+        for (size_t b = 0; b < std::size(budgets); ++b) {
+            const int budget = budgets[b] * int(actions.size());
+
+            for (int r = 0; r < n_repeats; ++r) {
+                std::vector<SampleStats> stats(actions.size());
+                for (size_t i = 0; i < actions.size(); ++i)
+                    for (int k = 0; k < budgets[b]; ++k)
+                        stats[i].add(mcts.sample(actions[i]));
+                score(stats, reference, budget, fixed[b]);
+
+                stats.assign(actions.size(), SampleStats{});
+                int spent = adaptive_sample(stats, budget, [&](size_t i) { return mcts.sample(actions[i]); });
+                if (spent > budget) {
+                    std::cout << "Adaptive sampler spent " << spent << " playouts out of " << budget << std::endl;
+                    return EXIT_FAILURE;
+                }
+                score(stats, reference, spent, adaptive[b]);
+            }
+        }
+    }
+
+    std::cout << "Reference: " << n_reference_samples << " playouts per action, "
+              << n_positions << " positions\n" << std::fixed << std::setprecision(3);
+    for (size_t b = 0; b < std::size(budgets); ++b) {
+        for (auto [name, s] : { std::pair{ "fixed   ", fixed[b] }, std::pair{ "adaptive", adaptive[b] } }) {
+            std::cout << std::setw(2) << budgets[b] << " samples per action, " << name
+                      << ": playouts per expansion " << std::setprecision(1) << double(s.playouts) / s.n
+                      << ", best action " << std::setprecision(3) << double(s.hits) / s.n
+                      << ", regret " << s.regret / s.n << '\n';
+        }
+    }
+    std::cout << "OK" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,315 @@
+#include "types.h"
+#include "game.h"
+#include "mcts.h"
+#include "epsilonGreedy.h"
+#include "random.h"
+
+#include <nlohmann/json.hpp>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+
+constexpr int default_mcts_iterations = 3000;
+constexpr int default_agent_iterations = 5000;
+constexpr int default_time_ms = 200;
+constexpr int default_n_repetitions = 3;
+constexpr double default_tolerance = 0.1;
+
+const char* usage = R"(Usage: benchmark_search [options]
+
+Search a fixed suite of positions with Mcts and with the epsilon-greedy
+agent, once for a fixed number of iterations and once for a fixed time,
+and report the throughput of each search. The best of a few repetitions
+is kept for each of them. The searches are seeded, so that those
+with a fixed number of iterations do the same work on every run and
+every repetition. When built with BT_PROFILE, the JSON results
+also hold the profile of each Mcts search.
+
+With --baseline, the results are compared with those of an earlier run
+(written with --output on the same machine) and the exit status is non
+zero if the iterations or playouts per second dropped, or the peak
+tree memory grew, by more than the tolerance.
+
+tests/search_benchmark_baseline.json is the reference run, made from
+the build directory with the default settings:
+
+    ./benchmark_search --seed 2022 --output ../tests/search_benchmark_baseline.json
+
+Throughputs only compare on the same machine: regenerate it there the
+same way, on an idle machine, before measuring a change against it,
+and commit it again when a change moves the throughput on purpose.
+Short searches are noisy, so raise the tolerance on a busy machine.
+
+Options:
+    --mcts-iterations N     (3000)
+    --agent-iterations N    (5000)
+    --time-ms N             time per search in the fixed time runs (200)
+    --reps N                repetitions of each search (3)
+    --seed N                seed of the searches (2022)
+    --output FILE           write the results as JSON
+    --baseline FILE         compare with these results
+    --tolerance X           relative drop allowed (0.1)
+)";
+
+struct Position {
+    const char* name;
+    Bitboard white, black;
+    Color side;
+};
+
+/// Middlegames reached by seeded random play, where neither engine
+/// finds its move without searching, then hand-made endgames
+constexpr Position positions[] = {
+    { "middlegame-16", 0x0000000220c037fdULL, 0x7b96f30000000000ULL, Color::white },
+    { "middlegame-26", 0x000000002157bcaaULL, 0x8f7b502200000000ULL, Color::white },
+    { "middlegame-36", 0x00000004929b1a71ULL, 0x8a78ce6100000000ULL, Color::white },
+    { "middlegame-46", 0x000000404870432dULL, 0x2c70c21b00000000ULL, Color::white },
+    { "endgame-6v6",   0x0000000000906300ULL, 0x00a9440000000000ULL, Color::white },
+    { "endgame-4v4",   0x0000000000482200ULL, 0x0044120000000000ULL, Color::black },
+};
+
+struct Result {
+    std::string engine, mode, position;
+    double seconds = 0.0;
+    long iterations = 0;
+    long playouts = 0;
+    size_t nodes = 0;
+    size_t peak_memory = 0;
+    std::string move;
+    json profile;   // null unless built with BT_PROFILE
+
+    double iterations_per_s() const { return seconds > 0 ? iterations / seconds : 0.0; }
+    double playouts_per_s() const { return seconds > 0 ? playouts / seconds : 0.0; }
+};
+
+struct Options {
+    int mcts_iterations = default_mcts_iterations;
+    int agent_iterations = default_agent_iterations;
+    int time_ms = default_time_ms;
+    int n_reps = default_n_repetitions;
+    std::string output_fp, baseline_fp;
+    double tolerance = default_tolerance;
+    uint64_t seed = 2022;
+};
+
+Result search_mcts(Game& game, const Options& opt, bool timed) {
+    Mcts mcts(game);
+    mcts.set_n_iterations(opt.mcts_iterations);
+    if (timed)
+        mcts.set_time_limit(opt.time_ms);
+
+    auto start = std::chrono::steady_clock::now();
+    Action action = mcts.best_action();
+    Result r;
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    r.iterations = mcts.n_selections();
+    r.playouts = mcts.n_rollouts();
+    r.nodes = mcts.n_nodes();
+    r.peak_memory = mcts.peak_memory();
+    r.move = string_of(action);
+
+    std::ostringstream profile;
+    mcts.write_profile_json(profile);
+    r.profile = json::parse(profile.str());
+    return r;
+}
+
+Result search_agent(Game& game, const Options& opt, bool timed) {
+    Agent agent(game);
+    agent.set_n_iterations(opt.agent_iterations);
+    if (timed)
+        agent.set_time_limit(opt.time_ms);
+
+    auto start = std::chrono::steady_clock::now();
+    Action action = agent.best_action();
+    Result r;
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    r.iterations = r.playouts = agent.n_playouts();
+    r.move = string_of(action);
+    return r;
+}
+
+json to_json(const std::vector<Result>& results, const Options& opt) {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+
+    json j;
+    j["mcts_iterations"] = opt.mcts_iterations;
+    j["agent_iterations"] = opt.agent_iterations;
+    j["time_ms"] = opt.time_ms;
+    j["seed"] = opt.seed;
+    j["peak_rss_kb"] = usage.ru_maxrss;
+    j["results"] = json::array();
+    for (const auto& r : results) {
+        j["results"].push_back({
+            { "engine", r.engine },
+            { "mode", r.mode },
+            { "position", r.position },
+            { "seconds", r.seconds },
+            { "iterations_per_s", r.iterations_per_s() },
+            { "playouts_per_s", r.playouts_per_s() },
+            { "nodes", r.nodes },
+            { "peak_memory_kb", r.peak_memory / 1024 },
+            { "move", r.move },
+        });
+        if (!r.profile.is_null())
+            j["results"].back()["profile"] = r.profile;
+    }
+    return j;
+}
+
+/**
+ * Compare @results with the @baseline ones, print the differences
+ * and return the number of regressions.
+ */
+int compare(const std::vector<Result>& results, const json& baseline, const Options& opt) {
+    int n_regressions = 0;
+
+    for (const auto& r : results) {
+        auto it = std::find_if(baseline["results"].begin(), baseline["results"].end(), [&](const json& b) {
+            return b["engine"] == r.engine && b["mode"] == r.mode && b["position"] == r.position;
+        });
+        const std::string name = r.engine + "/" + r.mode + "/" + r.position;
+        if (it == baseline["results"].end()) {
+            std::cout << name << ": not in the baseline" << std::endl;
+            continue;
+        }
+        const json& b = *it;
+
+        auto check = [&](const char* what, double value, double base, bool higher_is_better) {
+            if (base <= 0)
+                return;
+            double ratio = value / base;
+            bool regressed = higher_is_better ? ratio < 1.0 - opt.tolerance : ratio > 1.0 + opt.tolerance;
+            if (regressed) {
+                ++n_regressions;
+                std::cout << "REGRESSION " << name << ": " << what << " " << std::fixed << std::setprecision(0)
+                          << value << " vs " << base << " (" << std::showpos << std::setprecision(1)
+                          << 100.0 * (ratio - 1.0) << std::noshowpos << "%)" << std::endl;
+            }
+        };
+
+        check("iterations/s", r.iterations_per_s(), b["iterations_per_s"], true);
+        check("playouts/s", r.playouts_per_s(), b["playouts_per_s"], true);
+        // With a fixed time, the tree grows with the speed of the search
+        if (r.mode == "iterations")
+            check("peak memory (KB)", double(r.peak_memory / 1024), b["peak_memory_kb"], false);
+
+        // The timed searches do not do the same work from one run to
+        // the next, so a different move is only reported
+        if (b["move"] != r.move)
+            std::cout << name << ": played " << r.move << " instead of "
+                      << b["move"].get<std::string>() << std::endl;
+    }
+    return n_regressions;
+}
+
+int main(int argc, char *argv[]) {
+    Options opt;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << usage;
+            return EXIT_FAILURE;
+        }
+        if (arg == "--mcts-iterations")       opt.mcts_iterations = std::stoi(argv[++i]);
+        else if (arg == "--agent-iterations") opt.agent_iterations = std::stoi(argv[++i]);
+        else if (arg == "--time-ms")          opt.time_ms = std::stoi(argv[++i]);
+        else if (arg == "--reps")             opt.n_reps = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--output")           opt.output_fp = argv[++i];
+        else if (arg == "--baseline")         opt.baseline_fp = argv[++i];
+        else if (arg == "--tolerance")        opt.tolerance = std::stod(argv[++i]);
+        else if (arg == "--seed")             opt.seed = std::stoull(argv[++i]);
+        else {
+            std::cerr << usage;
+            return EXIT_FAILURE;
+        }
+    }
+
+    json baseline;
+    if (!opt.baseline_fp.empty()) {
+        std::ifstream ifs{ opt.baseline_fp };
+        if (!ifs) {
+            std::cerr << "Failed to open " << opt.baseline_fp << std::endl;
+            return EXIT_FAILURE;
+        }
+        ifs >> baseline;
+        if (baseline["mcts_iterations"] != opt.mcts_iterations
+            || baseline["agent_iterations"] != opt.agent_iterations
+            || baseline["time_ms"] != opt.time_ms
+            || baseline["seed"] != opt.seed) {
+            std::cerr << "The baseline was run with other settings" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    Random::set_seed(opt.seed);
+    Game::init();
+    Game game;
+    std::vector<Result> results;
+
+    std::cout << std::left << std::setw(32) << "search" << std::right
+              << std::setw(12) << "iter/s" << std::setw(12) << "playouts/s"
+              << std::setw(10) << "nodes" << std::setw(12) << "peak KB" << "  move" << std::endl;
+
+    for (const char* engine : { "mcts", "agent" }) {
+        for (const char* mode : { "iterations", "time" }) {
+            for (const Position& p : positions) {
+                Result best;
+                for (int rep = 0; rep < opt.n_reps; ++rep) {
+                    game.set_position(p.white, p.black, p.side);
+                    Random::set_thread_stream(0);
+                    bool timed = std::string(mode) == "time";
+                    Result r = std::string(engine) == "mcts" ? search_mcts(game, opt, timed)
+                                                             : search_agent(game, opt, timed);
+                    if (rep == 0 || r.iterations_per_s() > best.iterations_per_s())
+                        best = r;
+                }
+                best.engine = engine;
+                best.mode = mode;
+                best.position = p.name;
+
+                std::cout << std::left << std::setw(32) << best.engine + "/" + best.mode + "/" + best.position
+                          << std::right << std::fixed << std::setprecision(0)
+                          << std::setw(12) << best.iterations_per_s()
+                          << std::setw(12) << best.playouts_per_s()
+                          << std::setw(10) << best.nodes
+                          << std::setw(12) << best.peak_memory / 1024
+                          << "  " << best.move << std::endl;
+                results.push_back(best);
+            }
+        }
+    }
+
+    json j = to_json(results, opt);
+    std::cout << "Peak RSS: " << j["peak_rss_kb"].get<long>() << "KB" << std::endl;
+
+    if (!opt.output_fp.empty()) {
+        std::ofstream ofs{ opt.output_fp };
+        ofs << std::setw(2) << j << std::endl;
+        if (!ofs) {
+            std::cerr << "Failed to write " << opt.output_fp << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!opt.baseline_fp.empty()) {
+        int n_regressions = compare(results, baseline, opt);
+        std::cout << n_regressions << " regression(s) against " << opt.baseline_fp
+                  << " with a tolerance of " << 100.0 * opt.tolerance << "%" << std::endl;
+        if (n_regressions > 0)
+            return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
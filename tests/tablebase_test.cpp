@@ -0,0 +1,123 @@
+#include "game.h"
+#include "solver.h"
+#include "tablebase.h"
+#include "types.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+
+constexpr int max_pieces = 4;
+constexpr int n_positions = 2000;
+
+const std::filesystem::path dir = std::filesystem::temp_directory_path() / "bt_tablebase_test";
+
+bool same_files(const std::filesystem::path& a, const std::filesystem::path& b) {
+    std::ifstream fa{ a, std::ios::binary }, fb{ b, std::ios::binary };
+    return std::equal(std::istreambuf_iterator<char>(fa), std::istreambuf_iterator<char>(),
+                      std::istreambuf_iterator<char>(fb), std::istreambuf_iterator<char>());
+}
+
+/**
+ * Generating with several threads must give the same tables.
+ */
+bool test_deterministic() {
+    Tablebase::generate(max_pieces, dir / "1", 1);
+    Tablebase::generate(max_pieces, dir / "4", 4);
+
+    for (const auto& entry : std::filesystem::directory_iterator(dir / "1")) {
+        if (!same_files(entry.path(), dir / "4" / entry.path().filename())) {
+            std::cout << entry.path().filename() << " differs" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Compare random positions with the solver, and check that
+ * their distances follow from the distances of their children.
+ */
+bool test_positions(const Tablebase& tb) {
+    Game game;
+    Solver solver(game);
+    StateData sd;
+    std::vector<Action> actions;
+    std::mt19937_64 eng{ 42 };
+    int n_unsolved = 0;
+
+    for (int i = 0; i < n_positions; ++i) {
+        int n_white = 1 + eng() % (max_pieces - 1);
+        int n_black = 1 + eng() % (max_pieces - n_white);
+        Bitboard white = 0, black = 0;
+        while (count(white) < n_white)
+            white |= Bitboard(1) << (eng() % 64);
+        while (count(black) < n_black)
+            black |= (Bitboard(1) << (eng() % 64)) & ~white;
+
+        game.set_position(white, black, eng() & 1 ? Color::white : Color::black);
+        if (game.is_lost() || (game.pieces(game.player_to_move()) & row_bb(relative(game.player_to_move(), Row::eight))))
+            continue;
+
+        TBResult result = tb.probe(game);
+        if (result.proof == Proof::unknown) {
+            std::cout << "Missing position\n" << game.view() << std::endl;
+            return false;
+        }
+
+        SolverResult proof = solver.solve();
+        n_unsolved += proof.proof == Proof::unknown;
+        if (proof.proof != Proof::unknown && proof.proof != result.proof) {
+            std::cout << "Solver disagrees\n" << game.view() << std::endl;
+            return false;
+        }
+
+        int win = 0, loss = 0;
+        game.compute_valid_actions(actions);
+        for (Action a : actions) {
+            game.apply(a, sd);
+            TBResult child = game.is_lost() || count(game.pieces(game.player_to_move())) == 0
+                ? TBResult{ Proof::loss, 0 }
+                : tb.probe(game);
+            game.undo(a);
+
+            if (child.proof == Proof::loss)
+                win = win ? std::min(win, child.distance + 1) : child.distance + 1;
+            else
+                loss = std::max(loss, child.distance + 1);
+        }
+
+        if (result.distance != (win ? win : loss)) {
+            std::cout << "Inconsistent distance " << result.distance << "\n" << game.view() << std::endl;
+            return false;
+        }
+    }
+
+    std::cout << n_unsolved << " positions were not solved by the solver" << std::endl;
+    return true;
+}
+
+int main() {
+    Game::init();
+
+    bool ok = test_deterministic();
+    std::cout << "Deterministic generation: " << (ok ? "OK" : "FAILED") << std::endl;
+
+    Tablebase tb;
+    if (!tb.load(dir / "4") || tb.max_pieces() != max_pieces) {
+        std::cout << "Failed to load the tablebases" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    bool positions_ok = test_positions(tb);
+    std::cout << "Positions: " << (positions_ok ? "OK" : "FAILED") << std::endl;
+
+    std::filesystem::remove_all(dir);
+
+    return ok && positions_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,143 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+namespace Trace {
+
+namespace {
+
+    struct Event {
+        const char* name;
+        const char* cat;
+        uint64_t ts;
+        uint64_t dur;
+        int64_t arg;
+        char phase;
+    };
+
+    /// Ring buffer of the events of one thread at a time
+    struct Buffer {
+        std::vector<Event> events;
+        uint64_t written = 0;
+        bool in_use = false;
+    };
+
+    /// Buffers of every thread which recorded events, guarded by
+    /// @trace_mutex, which is only taken when a thread gets or
+    /// gives back its buffer
+    std::mutex trace_mutex;
+    std::vector<std::unique_ptr<Buffer>> trace_buffers;
+    size_t trace_capacity = 1 << 16;
+    uint64_t trace_epoch = 0;
+
+    /// Gives the buffer of its thread back when the thread exits
+    struct Handle {
+        Buffer* buffer = nullptr;
+        ~Handle() {
+            if (buffer) {
+                std::lock_guard lock{ trace_mutex };
+                buffer->in_use = false;
+            }
+        }
+    };
+    thread_local Handle trace_handle;
+
+    Buffer& thread_buffer() {
+        if (!trace_handle.buffer) {
+            std::lock_guard lock{ trace_mutex };
+            for (auto& b : trace_buffers) {
+                if (!b->in_use) {
+                    trace_handle.buffer = b.get();
+                    break;
+                }
+            }
+            if (!trace_handle.buffer) {
+                trace_buffers.push_back(std::make_unique<Buffer>());
+                trace_handle.buffer = trace_buffers.back().get();
+                trace_handle.buffer->events.resize(trace_capacity);
+            }
+            trace_handle.buffer->in_use = true;
+        }
+        return *trace_handle.buffer;
+    }
+
+}  // namespace
+
+void detail::record(const char* name, const char* cat, char phase, uint64_t ts, uint64_t dur, int64_t arg) {
+    Buffer& b = thread_buffer();
+    b.events[b.written++ % b.events.size()] = Event{ name, cat, ts, dur, arg, phase };
+}
+
+/**
+ * Start recording, with room for the last @events_per_thread
+ * events of each thread.
+ */
+void enable(size_t events_per_thread) {
+    {
+        std::lock_guard lock{ trace_mutex };
+        trace_capacity = std::max<size_t>(events_per_thread, 1);
+        if (!trace_epoch)
+            trace_epoch = now();
+    }
+    detail::is_enabled.store(true, std::memory_order_relaxed);
+}
+
+void disable() {
+    detail::is_enabled.store(false, std::memory_order_relaxed);
+}
+
+void clear() {
+    std::lock_guard lock{ trace_mutex };
+    for (auto& b : trace_buffers)
+        b->written = 0;
+    trace_epoch = now();
+}
+
+/**
+ * Write the recorded events to @fp, each buffer being a thread of the
+ * timeline. The timestamps are in microseconds since enable().
+ */
+bool dump(const std::filesystem::path& fp) {
+    std::lock_guard lock{ trace_mutex };
+    std::ofstream ofs{ fp };
+    if (!ofs) {
+        std::cerr << "Failed to open trace file " << fp << std::endl;
+        return false;
+    }
+
+    ofs << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n" << std::fixed << std::setprecision(3);
+    bool first = true;
+    for (size_t tid = 0; tid < trace_buffers.size(); ++tid) {
+        const Buffer& b = *trace_buffers[tid];
+        ofs << (first ? "" : ",\n")
+            << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << tid
+            << ", \"args\": {\"name\": \"thread " << tid << "\"}}";
+        first = false;
+
+        const uint64_t n = std::min<uint64_t>(b.written, b.events.size());
+        for (uint64_t i = b.written - n; i < b.written; ++i) {
+            const Event& e = b.events[i % b.events.size()];
+            if (e.ts < trace_epoch)
+                continue;
+            ofs << ",\n{\"name\": \"" << e.name << "\", \"cat\": \"" << e.cat
+                << "\", \"ph\": \"" << e.phase << "\", \"pid\": 1, \"tid\": " << tid
+                << ", \"ts\": " << (e.ts - trace_epoch) / 1e3;
+            if (e.phase == 'X')
+                ofs << ", \"dur\": " << e.dur / 1e3;
+            else
+                ofs << ", \"s\": \"t\"";
+            ofs << ", \"args\": {\"arg\": " << e.arg << "}}";
+        }
+    }
+    ofs << "\n]}" << std::endl;
+    return bool(ofs);
+}
+
+} // namespace Trace
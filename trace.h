@@ -0,0 +1,81 @@
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+
+
+/**
+ * Timeline of the search, written in the Chrome trace event format
+ * (chrome://tracing, Perfetto).
+ *
+ * Tracing is off until enable() is called. Each thread then records
+ * its events into its own ring buffer, which only keeps the latest
+ * ones, so that recording takes no lock and costs a clock read and a
+ * few stores. When tracing is off, it costs a relaxed atomic load.
+ *
+ * The buffer of a thread which exits is handed to the next thread
+ * which records an event, so that threads started for each batch of
+ * work share a few lanes of the timeline. dump() must only be called
+ * while no thread records events.
+ *
+ * Event names and categories must be string literals.
+ */
+namespace Trace {
+
+namespace detail {
+    inline std::atomic<bool> is_enabled{ false };
+    void record(const char* name, const char* cat, char phase, uint64_t ts, uint64_t dur, int64_t arg);
+}
+
+void enable(size_t events_per_thread = 1 << 16);
+void disable();
+void clear();
+bool dump(const std::filesystem::path& fp);
+
+inline bool enabled() { return detail::is_enabled.load(std::memory_order_relaxed); }
+
+/// Nanoseconds on the steady clock
+inline uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// Start time of a span ended with complete(), 0 when tracing is off
+inline uint64_t start() { return enabled() ? now() : 0; }
+
+/// Record a span which started at @start_ns, with an argument @arg
+inline void complete(const char* name, const char* cat, uint64_t start_ns, int64_t arg = 0) {
+    if (start_ns && enabled())
+        detail::record(name, cat, 'X', start_ns, now() - start_ns, arg);
+}
+
+/// Record a point in time
+inline void instant(const char* name, const char* cat, int64_t arg = 0) {
+    if (enabled())
+        detail::record(name, cat, 'i', now(), 0, arg);
+}
+
+/// Span covering its own lifetime
+class Scope {
+public:
+    Scope(const char* name, const char* cat, int64_t arg = 0)
+        : m_name{ name }, m_cat{ cat }, m_arg{ arg }, m_start{ start() } {}
+    ~Scope() { complete(m_name, m_cat, m_start, m_arg); }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    void set_arg(int64_t arg) { m_arg = arg; }
+
+private:
+    const char* m_name;
+    const char* m_cat;
+    int64_t m_arg;
+    uint64_t m_start;
+};
+
+} // namespace Trace
+
+#endif // TRACE_H_
@@ -57,7 +57,7 @@ enum class Direction {
     up_left   = left + up,
 };
 
-using Key = uint32_t;
+using Key = uint64_t;
 
 /**
  * The least significant byte stores the source square,
@@ -173,6 +173,16 @@ constexpr Square relative_square_at(Color c, int col, int row) {
   return Square(col + (row << 3) ^ (56 * to_integral(c)));
 }
 
+/**
+ * Reflection accross the middle of the board, column a <-> column h.
+ */
+constexpr Square mirror(Square s) {
+  return Square(to_integral(s) ^ 7);
+}
+constexpr Action mirror(Action a) {
+  return make_action(mirror(from_square(a)), mirror(to_square(a)));
+}
+
 /**
  * Methods to convert squares and actions to and from strings
  */
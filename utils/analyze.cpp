@@ -0,0 +1,293 @@
+#include "types.h"
+#include "game.h"
+#include "alphabeta.h"
+#include "epsilonGreedy.h"
+#include "eval.h"
+#include "mcts.h"
+#include "nnue.h"
+#include "tablebase.h"
+#include "config.h"
+#include "random.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+const char* usage = R"(Usage: analyze [options] <positions>
+
+Search every position of a file with an engine, on several threads,
+and write for each of them, as CSV:
+
+    position,move,value,visits,time_ms
+
+The positions are given one per line in the notation of
+Game::set_position(), e.g. the start position is
+
+    bbbbbbbb/bbbbbbbb/8/8/8/8/wwwwwwww/wwwwwwww w
+
+Empty lines and lines starting with '#' are skipped.
+
+The value is the average reward of the move for the player to move
+with mcts and greedy, left empty when the move was found without
+sampling it, and the score of the deepest finished iteration with
+alphabeta. The visits are the playouts of the move with mcts and
+greedy, the nodes of the search with alphabeta.
+
+The search settings come from the configuration file. Each position
+is searched with its own random streams, so that the results do not
+depend on the thread which searches it.
+
+Options:
+    --engine mcts|greedy|alphabeta   (mcts)
+    --config FILE           (default_config.json)
+    --iterations N          iterations per search instead of the configured ones
+    --time-ms N             time per search instead of the configured one
+    --threads N             positions searched at once (all cores)
+    --seed N                seed of the searches instead of the configured one
+    --output FILE           write the CSV there instead of the standard output
+)";
+
+enum class Engine {
+    mcts, greedy, alphabeta
+};
+
+struct Options {
+    Engine engine = Engine::mcts;
+    std::string config_fp = "default_config.json";
+    std::string positions_fp;
+    std::string output_fp;
+    int n_iterations = -1;
+    int time_ms = -1;
+    int n_threads = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t seed = 0;
+};
+
+struct Analysis {
+    Action action = Action::none;
+    bool has_value = false;
+    double value = 0.0;
+    long visits = 0;
+    double ms = 0.0;
+};
+
+/// Read-only once loaded, shared by all the searches
+struct Resources {
+    const Tablebase* tablebase = nullptr;
+    const Nnue::Network* network = nullptr;
+};
+
+/**
+ * Search the position of @game with a new @engine set up from @config.
+ */
+Analysis analyze(Engine engine, const Config& config, const Resources& res, Game& game) {
+    Analysis ret;
+    auto start = std::chrono::steady_clock::now();
+
+    if (engine == Engine::mcts) {
+        auto mcts = std::make_unique<Mcts>(game);
+        mcts->set_n_iterations(config.iterations);
+        mcts->set_time_limit(config.time_ms);
+        mcts->set_exp_cst(config.exp_cst);
+        mcts->set_n_init_samples(config.init_samples);
+        mcts->set_adaptive_samples(config.adaptive_samples);
+        mcts->set_transposition_stats(config.transposition_stats);
+        mcts->set_symmetry(config.symmetry);
+        mcts->set_memory_budget(config.memory_budget_mb);
+        mcts->set_expansion_threshold(config.expansion_threshold);
+        mcts->set_root_policy(config.root_policy == "sequential_halving"
+                              ? RootPolicy::sequential_halving
+                              : RootPolicy::ucb);
+        mcts->set_solver_threshold(config.solver_threshold);
+        mcts->set_minimax_weight(config.minimax_weight);
+        mcts->set_tablebase(res.tablebase);
+        mcts->set_network(res.network);
+
+        ret.action = mcts->best_action();
+        auto [visits, value] = mcts->root_stats(ret.action);
+        ret.visits = visits;
+        ret.has_value = visits > 0;
+        ret.value = value;
+    }
+    else if (engine == Engine::greedy) {
+        Agent agent(game);
+        agent.set_n_iterations(config.iterations);
+        agent.set_time_limit(config.time_ms);
+        agent.set_epsilon(config.epsilon);
+        agent.set_epsilon_schedule(config.epsilon_mid_ply, config.epsilon_mid_factor,
+                                   config.epsilon_late_ply, config.epsilon_late_factor);
+        agent.set_n_initial_samples(config.init_samples);
+        agent.set_adaptive_samples(config.adaptive_samples);
+        agent.set_solver_threshold(config.solver_threshold);
+
+        ret.action = agent.best_action();
+        auto [visits, value] = agent.root_stats(ret.action);
+        ret.visits = visits;
+        ret.has_value = visits > 0;
+        ret.value = value;
+    }
+    else {
+        auto alphabeta = std::make_unique<AlphaBeta>(game);
+        if (config.time_ms > 0)
+            alphabeta->set_time_limit(config.time_ms);
+        alphabeta->set_network(res.network);
+
+        ret.action = alphabeta->best_action();
+        ret.visits = alphabeta->n_nodes();
+        ret.has_value = true;
+        ret.value = alphabeta->score();
+    }
+
+    ret.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return ret;
+}
+
+/**
+ * Read the positions of @fp, checking their notation.
+ */
+std::vector<std::string> read_positions(const std::string& fp) {
+    std::ifstream ifs{ fp };
+    if (!ifs)
+        throw std::invalid_argument("failed to open " + fp);
+
+    std::vector<std::string> ret;
+    Game game;
+    std::string line;
+    for (int n = 1; std::getline(ifs, line); ++n) {
+        line.erase(0, line.find_first_not_of(" \t"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (line.empty() || line[0] == '#')
+            continue;
+        if (!game.set_position(line))
+            throw std::invalid_argument(fp + ":" + std::to_string(n) + ": invalid position " + line);
+        if (game.is_lost() || !game.pieces(game.player_to_move()))
+            throw std::invalid_argument(fp + ":" + std::to_string(n) + ": the game is over in " + line);
+        ret.push_back(line);
+    }
+    return ret;
+}
+
+int main(int argc, char *argv[]) {
+    Options opt;
+    std::vector<std::string> positions;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&] {
+                if (i + 1 >= argc)
+                    throw std::invalid_argument("missing value after " + arg);
+                return std::string(argv[++i]);
+            };
+
+            if (arg == "--engine") {
+                std::string name = value();
+                opt.engine = name == "mcts" ? Engine::mcts
+                           : name == "greedy" ? Engine::greedy
+                           : name == "alphabeta" ? Engine::alphabeta
+                           : throw std::invalid_argument("unknown engine " + name);
+            }
+            else if (arg == "--config")        opt.config_fp = value();
+            else if (arg == "--iterations")    opt.n_iterations = std::stoi(value());
+            else if (arg == "--time-ms")       opt.time_ms = std::stoi(value());
+            else if (arg == "--threads")       opt.n_threads = std::max(1, std::stoi(value()));
+            else if (arg == "--seed")          opt.seed = std::stoull(value());
+            else if (arg == "--output")        opt.output_fp = value();
+            else if (arg.rfind("--", 0) == 0)  throw std::invalid_argument("unknown option " + arg);
+            else if (opt.positions_fp.empty()) opt.positions_fp = arg;
+            else                               throw std::invalid_argument("more than one positions file");
+        }
+        if (opt.positions_fp.empty())
+            throw std::invalid_argument("no positions file");
+
+        Game::init();
+        positions = read_positions(opt.positions_fp);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n\n" << usage;
+        return EXIT_FAILURE;
+    }
+
+    auto [config_ok, config] = get_config(opt.config_fp);
+    if (!config_ok) {
+        std::cerr << "Failed to load config" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (opt.n_iterations >= 0)
+        config.iterations = opt.n_iterations;
+    if (opt.time_ms >= 0)
+        config.time_ms = opt.time_ms;
+    Random::set_seed(opt.seed ? opt.seed : config.seed);
+
+    Tablebase tablebase;
+    Nnue::Network network;
+    Resources res;
+    if (!config.tablebase_dir.empty() && tablebase.load(config.tablebase_dir))
+        res.tablebase = &tablebase;
+    if (!config.nnue_file.empty() && network.load(config.nnue_file))
+        res.network = &network;
+
+    std::vector<Analysis> results(positions.size());
+    std::atomic<size_t> next{ 0 };
+    auto start = std::chrono::steady_clock::now();
+
+    auto worker = [&] {
+        set_eval_weights(config.eval);
+        Game game;
+
+        for (size_t i = next++; i < positions.size(); i = next++) {
+            Random::set_thread_stream(i);
+            game.set_position(positions[i]);
+            results[i] = analyze(opt.engine, config, res, game);
+
+            std::ostringstream ss;
+            ss << "Position " << i + 1 << "/" << positions.size() << ": "
+               << string_of(results[i].action) << '\n';
+            std::cerr << ss.str();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < opt.n_threads; ++t)
+        threads.emplace_back(worker);
+    for (auto& t : threads)
+        t.join();
+
+    std::ofstream ofs;
+    if (!opt.output_fp.empty()) {
+        ofs.open(opt.output_fp);
+        if (!ofs) {
+            std::cerr << "Failed to open " << opt.output_fp << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    std::ostream& out = opt.output_fp.empty() ? std::cout : ofs;
+
+    out << "position,move,value,visits,time_ms\n";
+    for (size_t i = 0; i < positions.size(); ++i) {
+        const Analysis& a = results[i];
+        out << positions[i] << ',' << string_of(a.action) << ',';
+        if (a.has_value)
+            out << std::fixed << std::setprecision(opt.engine == Engine::alphabeta ? 0 : 4) << a.value;
+        out << ',' << a.visits << ',' << std::fixed << std::setprecision(1) << a.ms << '\n';
+    }
+    out.flush();
+    if (!out) {
+        std::cerr << "Failed to write the results" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Analyzed " << positions.size() << " positions in " << std::fixed << std::setprecision(1)
+              << elapsed << "s (" << positions.size() / elapsed << " positions/s)" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -3,6 +3,7 @@
 #include "game.h"
 #include "agentRandom.h"
 #include "config.h"
+#include "random.h"
 
 #include <iostream>
 #include <fstream>
@@ -33,6 +34,7 @@ int main(int argc, char* argv[]) {
         return EXIT_FAILURE;
     }
 
+    Random::set_seed(config.seed);
     Game::init();
     Game game;
     Mcts mcts(game);
@@ -54,8 +56,28 @@ int main(int argc, char* argv[]) {
     };
 
     mcts.set_n_iterations(config.iterations);
+    mcts.set_time_limit(config.time_ms);
     mcts.set_exp_cst(config.exp_cst);
     mcts.set_n_init_samples(config.init_samples);
+    mcts.set_adaptive_samples(config.adaptive_samples);
+    mcts.set_transposition_stats(config.transposition_stats);
+    mcts.set_symmetry(config.symmetry);
+    mcts.set_memory_budget(config.memory_budget_mb);
+    mcts.set_expansion_threshold(config.expansion_threshold);
+    mcts.set_root_policy(config.root_policy == "sequential_halving"
+                         ? RootPolicy::sequential_halving
+                         : RootPolicy::ucb);
+    mcts.set_solver_threshold(config.solver_threshold);
+    mcts.set_minimax_weight(config.minimax_weight);
+    set_eval_weights(config.eval);
+
+    Tablebase tablebase;
+    if (!config.tablebase_dir.empty() && tablebase.load(config.tablebase_dir))
+        mcts.set_tablebase(&tablebase);
+
+    Nnue::Network network;
+    if (!config.nnue_file.empty() && network.load(config.nnue_file))
+        mcts.set_network(&network);
 
     while (!game.is_lost()) {
         Action a;
@@ -0,0 +1,30 @@
+#include "game.h"
+#include "tablebase.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+
+constexpr int default_max_pieces = 5;
+constexpr auto default_dir = "data/tablebases";
+
+/**
+ * Usage: generate_tablebases [max_pieces] [output_dir] [n_threads]
+ */
+int main(int argc, char *argv[]) {
+    Game::init();
+
+    int max_pieces = argc > 1 ? std::stoi(argv[1]) : default_max_pieces;
+    std::string dir = argc > 2 ? argv[2] : default_dir;
+    int n_threads = argc > 3 ? std::stoi(argv[3]) : int(std::thread::hardware_concurrency());
+
+    auto start = std::chrono::steady_clock::now();
+    Tablebase::generate(max_pieces, dir, n_threads);
+
+    std::cout << "Generated tablebases with up to " << max_pieces << " pieces in "
+        << std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::steady_clock::now() - start).count() << "s"
+        << std::endl;
+}
@@ -3,8 +3,32 @@
 import json
 
 default_config = {"iterations": 600,
+                  "time_ms": 0,
+                  "seed": 0,
                   "exp_cst": 1.0,
                   "init_samples": 1,
+                  "adaptive_samples": False,
+                  "transposition_stats": False,
+                  "symmetry": False,
+                  "memory_budget_mb": 0,
+                  "expansion_threshold": 1,
+                  "root_policy": "ucb",
+                  "solver_threshold": 0,
+                  "minimax_weight": 0.0,
+                  "epsilon": 0.1,
+                  "epsilon_mid_ply": 32,
+                  "epsilon_mid_factor": 0.5,
+                  "epsilon_late_ply": 64,
+                  "epsilon_late_factor": 0.25,
+                  "eval": {"lever": 0.2,
+                           "structure": 0.3,
+                           "material": 0.5,
+                           "phalanx": 2.0,
+                           "runner_in_3": 0.8,
+                           "threatened": 0.35,
+                           "threatened_weight": 0.33},
+                  "tablebase_dir": "",
+                  "nnue_file": "",
                   "dump_tree": True,
                   "jsontree_datadir": "view/data/jsontree",
                   "jsontree_fn": "jsontree_ply_",
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""Read the self-play records written by utils/selfplay.cpp.
+
+The layout is documented in record.h. Records are read in a streaming
+way with iter_records(), or the fixed part of all of them is loaded at
+once in a numpy array with read_positions().
+
+Usage: records.py records.bin [records.bin ...]
+    prints a summary of the files.
+"""
+
+import struct
+import sys
+
+MAGIC = 0x50535442  # "BTSP"
+VERSION = 1
+
+HEADER = struct.Struct("<2I")
+FIXED = struct.Struct("<QQBbHB")
+VISIT = struct.Struct("<HH")
+
+
+class Record:
+    __slots__ = ("white", "black", "side", "result", "ply", "visits")
+
+    def __init__(self, white, black, side, result, ply, visits):
+        self.white = white
+        self.black = black
+        self.side = side
+        self.result = result
+        self.ply = ply
+        self.visits = visits  # list of (action, visits)
+
+
+def _check_header(data, path):
+    if len(data) < HEADER.size or HEADER.unpack_from(data) != (MAGIC, VERSION):
+        raise ValueError(f"{path} is not a record file")
+
+
+def iter_records(paths, chunk_size=1 << 20):
+    """Yield the records of the files @paths one at a time."""
+    for path in paths:
+        with open(path, "rb") as f:
+            data = f.read(HEADER.size)
+            _check_header(data, path)
+            data = b""
+            offset = 0
+            while True:
+                chunk = f.read(chunk_size)
+                if chunk:
+                    data = data[offset:] + chunk
+                    offset = 0
+                while len(data) - offset >= FIXED.size:
+                    white, black, side, result, ply, n = FIXED.unpack_from(data, offset)
+                    end = offset + FIXED.size + n * VISIT.size
+                    if end > len(data):
+                        break
+                    visits = [VISIT.unpack_from(data, offset + FIXED.size + i * VISIT.size) for i in range(n)]
+                    yield Record(white, black, side, result, ply, visits)
+                    offset = end
+                if not chunk:
+                    break
+
+
+def read_positions(paths):
+    """numpy structured array with the white, black, side, result
+    and ply of every record of the files @paths."""
+    import numpy as np
+
+    dtype = np.dtype([("white", "<u8"), ("black", "<u8"), ("side", "u1"), ("result", "i1"), ("ply", "<u2")])
+    arrays = []
+    for path in paths:
+        data = np.fromfile(path, dtype=np.uint8)
+        _check_header(data[:HEADER.size].tobytes(), path)
+
+        # Offsets of the records, which have a variable size
+        offsets = []
+        offset, size = HEADER.size, len(data)
+        n_actions = FIXED.size - 1
+        while offset + FIXED.size <= size:
+            offsets.append(offset)
+            offset += FIXED.size + VISIT.size * int(data[offset + n_actions])
+        if offset > size:
+            offsets.pop()
+        offsets = np.array(offsets, dtype=np.int64)
+
+        out = np.empty(len(offsets), dtype)
+        field = lambda begin, n: data[offsets[:, None] + np.arange(begin, begin + n)]
+        out["white"] = field(0, 8).copy().view("<u8")[:, 0]
+        out["black"] = field(8, 8).copy().view("<u8")[:, 0]
+        out["side"] = data[offsets + 16]
+        out["result"] = data[offsets + 17].view(np.int8)
+        out["ply"] = field(18, 2).copy().view("<u2")[:, 0]
+        arrays.append(out)
+
+    return np.concatenate(arrays) if arrays else np.empty(0, dtype)
+
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit(__doc__)
+
+    n = n_actions = n_white_wins = 0
+    max_ply = 0
+    for r in iter_records(sys.argv[1:]):
+        n += 1
+        n_actions += len(r.visits)
+        n_white_wins += (r.result > 0) == (r.side == 0)
+        max_ply = max(max_ply, r.ply)
+
+    print(f"{n} records, {n_actions / max(n, 1):.1f} actions per record, "
+          f"white won {100 * n_white_wins / max(n, 1):.1f}% of the positions, max ply {max_ply}")
+
+
+if __name__ == '__main__':
+    main()
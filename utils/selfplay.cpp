@@ -0,0 +1,221 @@
+#include "types.h"
+#include "game.h"
+#include "eval.h"
+#include "mcts.h"
+#include "record.h"
+#include "config.h"
+#include "random.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+constexpr int default_n_games = 100;
+constexpr int default_opening_plies = 4;
+constexpr int default_sample_plies = 8;
+constexpr int default_max_file_mb = 64;
+
+const char* usage = R"(Usage: selfplay [options]
+
+Play Mcts against itself on several threads and write every searched
+position with the root visit distribution and the final result, in
+the binary format of record.h. Each thread writes its own files,
+named PREFIX-tN-00000.bin, PREFIX-tN-00001.bin...
+
+The search settings come from the configuration file.
+
+Options:
+    --config FILE           (default_config.json)
+    --output PREFIX         prefix of the record files (selfplay)
+    --games N               games to play (100)
+    --threads N             games played at once (all cores)
+    --max-file-mb N         start a new file past that size (64)
+    --opening-plies N       random plies played before searching (4)
+    --sample-plies N        plies, after the opening, where the move is drawn
+                            in proportion to the visits instead of being
+                            the most visited one (8)
+    --seed N                (2022)
+)";
+
+struct Options {
+    std::string config_fp = "default_config.json";
+    std::filesystem::path prefix = "selfplay";
+    int n_games = default_n_games;
+    int n_threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t max_file_bytes = size_t(default_max_file_mb) << 20;
+    int opening_plies = default_opening_plies;
+    int sample_plies = default_sample_plies;
+    unsigned seed = 2022;
+};
+
+void configure(Mcts& mcts, const Config& config) {
+    mcts.set_n_iterations(config.iterations);
+    mcts.set_time_limit(config.time_ms);
+    mcts.set_exp_cst(config.exp_cst);
+    mcts.set_n_init_samples(config.init_samples);
+    mcts.set_adaptive_samples(config.adaptive_samples);
+    mcts.set_transposition_stats(config.transposition_stats);
+    mcts.set_symmetry(config.symmetry);
+    mcts.set_memory_budget(config.memory_budget_mb);
+    mcts.set_expansion_threshold(config.expansion_threshold);
+    mcts.set_root_policy(config.root_policy == "sequential_halving"
+                         ? RootPolicy::sequential_halving
+                         : RootPolicy::ucb);
+    mcts.set_solver_threshold(config.solver_threshold);
+    mcts.set_minimax_weight(config.minimax_weight);
+}
+
+int main(int argc, char* argv[]) {
+    Options opt;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&] {
+                if (i + 1 >= argc)
+                    throw std::invalid_argument("missing value after " + arg);
+                return std::string(argv[++i]);
+            };
+
+            if (arg == "--config")             opt.config_fp = value();
+            else if (arg == "--output")        opt.prefix = value();
+            else if (arg == "--games")         opt.n_games = std::stoi(value());
+            else if (arg == "--threads")       opt.n_threads = std::max(1, std::stoi(value()));
+            else if (arg == "--max-file-mb")   opt.max_file_bytes = std::stoul(value()) << 20;
+            else if (arg == "--opening-plies") opt.opening_plies = std::stoi(value());
+            else if (arg == "--sample-plies")  opt.sample_plies = std::stoi(value());
+            else if (arg == "--seed")          opt.seed = std::stoul(value());
+            else                               throw std::invalid_argument("unknown option " + arg);
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n\n" << usage;
+        return EXIT_FAILURE;
+    }
+
+    auto [config_ok, config] = get_config(opt.config_fp);
+    if (!config_ok) {
+        std::cerr << "Failed to load config" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    Random::set_seed(opt.seed);
+    Game::init();
+
+    // Read-only once loaded, shared by all the searches
+    Tablebase tablebase;
+    bool has_tablebase = !config.tablebase_dir.empty() && tablebase.load(config.tablebase_dir);
+    Nnue::Network network;
+    bool has_network = !config.nnue_file.empty() && network.load(config.nnue_file);
+
+    std::atomic<int> next_game{ 0 };
+    std::atomic<long> n_positions{ 0 };
+    std::atomic<bool> failed{ false };
+    auto start = std::chrono::steady_clock::now();
+
+    auto worker = [&](int thread_id) {
+        set_eval_weights(config.eval);
+
+        Game game;
+        Mcts mcts(game);
+        configure(mcts, config);
+        if (has_tablebase)
+            mcts.set_tablebase(&tablebase);
+        if (has_network)
+            mcts.set_network(&network);
+
+        auto prefix = opt.prefix;
+        prefix += "-t" + std::to_string(thread_id);
+        Records::Writer writer{ prefix, opt.max_file_bytes };
+
+        StateData states[max_depth];
+        std::vector<Action> actions;
+        std::vector<std::pair<Action, int>> visits;
+        std::vector<Records::Record> records;
+
+        for (int g = next_game++; g < opt.n_games && !failed; g = next_game++) {
+            std::mt19937 eng{ opt.seed + unsigned(g) };
+            // The searches of a game do not depend on the thread playing it
+            Random::set_thread_stream(g);
+            mcts.set_rng(Random::stream(Random::Component::mcts));
+            game.reset();
+            StateData* sd = &states[0];
+            records.clear();
+
+            for (int i = 0; i < opt.opening_plies && !game.is_lost(); ++i) {
+                game.compute_valid_actions(actions);
+                game.apply(actions[eng() % actions.size()], *sd++);
+            }
+
+            for (int searched = 0; !game.is_lost() && game.pieces(game.player_to_move()); ++searched) {
+                mcts.reset(game);
+                Action action = mcts.best_action();
+                mcts.root_visits(visits);
+                if (visits.empty())
+                    visits.emplace_back(action, 1);
+
+                if (searched < opt.sample_plies) {
+                    std::vector<int> weights;
+                    for (auto [a, n] : visits)
+                        weights.push_back(n);
+                    if (std::any_of(weights.begin(), weights.end(), [](int n) { return n > 0; })) {
+                        std::discrete_distribution<size_t> draw(weights.begin(), weights.end());
+                        action = visits[draw(eng)].first;
+                    }
+                }
+
+                auto& record = records.emplace_back();
+                record.white = game.pieces(Color::white);
+                record.black = game.pieces(Color::black);
+                record.side = game.player_to_move();
+                record.ply = uint16_t(game.ply());
+                record.set_visits(visits);
+
+                game.apply(action, *sd++);
+            }
+
+            // The player to move has lost
+            Color winner = opposite_of(game.player_to_move());
+            for (auto& record : records) {
+                record.result = record.side == winner ? 1 : -1;
+                if (!writer.write(record))
+                    failed = true;
+            }
+            n_positions += long(records.size());
+
+            std::ostringstream ss;
+            ss << "Game " << g + 1 << "/" << opt.n_games << ": "
+               << (winner == Color::white ? "white" : "black") << " won in "
+               << game.ply() << " plies\n";
+            std::cerr << ss.str();
+        }
+
+        if (!writer.flush())
+            failed = true;
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < opt.n_threads; ++t)
+        threads.emplace_back(worker, t);
+    for (auto& t : threads)
+        t.join();
+
+    if (failed) {
+        std::cerr << "Writing the records failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Wrote " << n_positions << " positions of " << opt.n_games << " games in "
+              << elapsed << "s (" << n_positions / elapsed << " positions/s)" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+"""Train the network of nnue.h on self-play records and write its weights.
+
+Usage: train_nnue.py output.nnue records.bin [records.bin ...]
+
+The records are those written by utils/selfplay.cpp, read with
+records.py: only the position, the side to move and the result of
+the game are used.
+
+The network is trained in floating point with the same clipped
+activations as the engine, then quantized to the layout documented
+in nnue.h.
+"""
+
+import argparse
+import struct
+import sys
+
+import numpy as np
+
+from records import read_positions
+
+N_SQUARES = 64
+N_INPUTS = 2 * N_SQUARES
+N_HIDDEN = 64
+N_L2 = 16
+
+ACTIVATION_SCALE = 127
+WEIGHT_SCALE = 64
+
+MAGIC = 0x4E4E5442  # "BTNN"
+VERSION = 1
+
+
+def squares(bitboards):
+    """(n, 64) array of the bits of @bitboards."""
+    bytes_ = bitboards.astype("<u8").view(np.uint8).reshape(-1, 8)
+    return np.unpackbits(bytes_, axis=1, bitorder="little").astype(np.float32)
+
+
+def flip(board):
+    """Flip (n, 64) boards vertically."""
+    return board.reshape(-1, 8, 8)[:, ::-1, :].reshape(-1, N_SQUARES)
+
+
+def inputs(records):
+    """Inputs of the player to move and of its opponent, each
+    with its own pieces first and seen as if it were white."""
+    white = squares(records["white"])
+    black = squares(records["black"])
+    from_white = np.concatenate([white, black], axis=1)
+    from_black = np.concatenate([flip(black), flip(white)], axis=1)
+
+    black_to_move = (records["side"] == 1)[:, None]
+    us = np.where(black_to_move, from_black, from_white)
+    them = np.where(black_to_move, from_white, from_black)
+    return us, them
+
+
+class Model:
+    def __init__(self, rng):
+        self.params = {
+            "b1": np.zeros(N_HIDDEN, np.float32),
+            "w1": rng.normal(0, 0.1, (N_INPUTS, N_HIDDEN)).astype(np.float32),
+            "b2": np.zeros(N_L2, np.float32),
+            "w2": rng.normal(0, 1 / np.sqrt(2 * N_HIDDEN), (N_L2, 2 * N_HIDDEN)).astype(np.float32),
+            "b3": np.zeros(1, np.float32),
+            "w3": rng.normal(0, 1 / np.sqrt(N_L2), N_L2).astype(np.float32),
+        }
+        self.moments = {k: (np.zeros_like(v), np.zeros_like(v)) for k, v in self.params.items()}
+        self.steps = 0
+
+    def forward(self, us, them):
+        p = self.params
+        a_us = us @ p["w1"] + p["b1"]
+        a_them = them @ p["w1"] + p["b1"]
+        h = np.clip(np.concatenate([a_us, a_them], axis=1), 0, 1)
+        a2 = h @ p["w2"].T + p["b2"]
+        z = np.clip(a2, 0, 1)
+        logit = z @ p["w3"] + p["b3"]
+        return logit, (us, them, a_us, a_them, h, a2, z)
+
+    def backward(self, dlogit, cache):
+        us, them, a_us, a_them, h, a2, z = cache
+        p = self.params
+        grads = {"b3": np.array([dlogit.sum()]), "w3": z.T @ dlogit}
+
+        da2 = np.outer(dlogit, p["w3"]) * ((a2 > 0) & (a2 < 1))
+        grads["b2"] = da2.sum(axis=0)
+        grads["w2"] = da2.T @ h
+
+        dh = da2 @ p["w2"]
+        da_us = dh[:, :N_HIDDEN] * ((a_us > 0) & (a_us < 1))
+        da_them = dh[:, N_HIDDEN:] * ((a_them > 0) & (a_them < 1))
+        grads["b1"] = da_us.sum(axis=0) + da_them.sum(axis=0)
+        grads["w1"] = us.T @ da_us + them.T @ da_them
+        return grads
+
+    def step(self, grads, lr, beta1=0.9, beta2=0.999, eps=1e-8):
+        """Adam update, keeping the last two layers within the int8 range."""
+        self.steps += 1
+        for k, g in grads.items():
+            m, v = self.moments[k]
+            m[:] = beta1 * m + (1 - beta1) * g
+            v[:] = beta2 * v + (1 - beta2) * g * g
+            m_hat = m / (1 - beta1 ** self.steps)
+            v_hat = v / (1 - beta2 ** self.steps)
+            self.params[k] -= lr * m_hat / (np.sqrt(v_hat) + eps)
+
+        limit = 127 / WEIGHT_SCALE
+        np.clip(self.params["w2"], -limit, limit, out=self.params["w2"])
+        np.clip(self.params["w3"], -limit, limit, out=self.params["w3"])
+
+    def write(self, path):
+        p = self.params
+        q = lambda x, scale, dtype: np.round(x * scale).clip(np.iinfo(dtype).min, np.iinfo(dtype).max).astype(dtype)
+
+        with open(path, "wb") as f:
+            f.write(struct.pack("<5I", MAGIC, VERSION, N_INPUTS, N_HIDDEN, N_L2))
+            f.write(q(p["b1"], ACTIVATION_SCALE, np.int16).astype("<i2").tobytes())
+            f.write(q(p["w1"], ACTIVATION_SCALE, np.int16).astype("<i2").tobytes())
+            f.write(q(p["b2"], ACTIVATION_SCALE * WEIGHT_SCALE, np.int32).astype("<i4").tobytes())
+            f.write(q(p["w2"], WEIGHT_SCALE, np.int8).tobytes())
+            f.write(q(p["b3"], ACTIVATION_SCALE * WEIGHT_SCALE, np.int32).astype("<i4").tobytes())
+            f.write(q(p["w3"], WEIGHT_SCALE, np.int8).tobytes())
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("output")
+    parser.add_argument("records", nargs="+")
+    parser.add_argument("--epochs", type=int, default=10)
+    parser.add_argument("--batch-size", type=int, default=1024)
+    parser.add_argument("--lr", type=float, default=1e-3)
+    parser.add_argument("--validation", type=float, default=0.05, help="fraction of the records held out")
+    parser.add_argument("--seed", type=int, default=2022)
+    args = parser.parse_args()
+
+    rng = np.random.default_rng(args.seed)
+    records = read_positions(args.records)
+    if len(records) == 0:
+        sys.exit("No records found")
+    records = records[rng.permutation(len(records))]
+
+    us, them = inputs(records)
+    target = (records["result"] > 0).astype(np.float32)
+    n_valid = int(len(records) * args.validation)
+
+    model = Model(rng)
+    for epoch in range(args.epochs):
+        order = n_valid + rng.permutation(len(records) - n_valid)
+        for begin in range(0, len(order), args.batch_size):
+            batch = order[begin:begin + args.batch_size]
+            logit, cache = model.forward(us[batch], them[batch])
+            # Gradient of the mean binary cross-entropy with respect to the logit
+            dlogit = (1 / (1 + np.exp(-logit)) - target[batch]) / len(batch)
+            model.step(model.backward(dlogit, cache), args.lr)
+
+        if n_valid:
+            logit, _ = model.forward(us[:n_valid], them[:n_valid])
+            prob = np.clip(1 / (1 + np.exp(-logit)), 1e-7, 1 - 1e-7)
+            t = target[:n_valid]
+            loss = -np.mean(t * np.log(prob) + (1 - t) * np.log(1 - prob))
+            print(f"epoch {epoch + 1}: validation loss {loss:.4f}")
+
+    model.write(args.output)
+    print(f"Wrote {args.output}")
+
+
+if __name__ == '__main__':
+    main()
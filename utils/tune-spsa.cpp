@@ -0,0 +1,335 @@
+#include "game.h"
+#include "alphabeta.h"
+#include "epsilonGreedy.h"
+#include "eval.h"
+#include "mcts.h"
+#include "config.h"
+#include "random.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+constexpr int default_n_iterations = 200;
+constexpr int default_opening_plies = 4;
+constexpr double default_a = 0.01;
+constexpr double default_c = 0.1;
+
+const char* usage = R"(Usage: tune_spsa [options]
+
+Tune the parameters of an engine with SPSA: at each iteration, the
+parameters are perturbed in a random direction both ways, the two
+versions play a batch of games against each other on all cores, and
+the parameters move towards the one which won more often. The tuned
+values are written back to a copy of the configuration.
+
+Options:
+    --engine mcts|greedy|alphabeta   engine to tune (mcts)
+    --params a,b,...        parameters to tune (by default those of the engine)
+    --config FILE           configuration to start from (default_config.json)
+    --output FILE           tuned configuration (tuned_config.json)
+    --iterations N          SPSA iterations (200)
+    --games N               games per iteration (twice the number of threads)
+    --threads N             games played at once (all cores)
+    --time-ms N             time per move instead of the configured iterations,
+                            to tune the strength per CPU-second
+    --opening-plies N       random plies played from the start position (4)
+    --a A --c C             step and perturbation sizes, relative to the
+                            range of each parameter (0.01, 0.1)
+    --seed N                (2022)
+)";
+
+/// Range of the values tried for a tunable parameter of Config.
+struct Param {
+    std::string_view name;
+    double min, max;
+};
+
+constexpr Param params_ranges[] = {
+    { "exp_cst", 0.1, 3.0 },
+    { "init_samples", 1, 16 },
+    { "minimax_weight", 0.0, 1.0 },
+    { "epsilon", 0.0, 0.5 },
+    { "epsilon_mid_ply", 8, 80 },
+    { "epsilon_mid_factor", 0.0, 1.0 },
+    { "epsilon_late_ply", 16, 120 },
+    { "epsilon_late_factor", 0.0, 1.0 },
+    { "eval.lever", 0.0, 1.0 },
+    { "eval.structure", 0.0, 1.0 },
+    { "eval.material", 0.0, 1.0 },
+    { "eval.phalanx", 0.0, 4.0 },
+    { "eval.runner_in_3", 0.5, 1.0 },
+    { "eval.threatened", 0.0, 1.0 },
+    { "eval.threatened_weight", 0.1, 0.5 },
+};
+
+const Param& param_of(std::string_view name) {
+    for (const Param& p : params_ranges)
+        if (p.name == name)
+            return p;
+    throw std::invalid_argument("unknown parameter " + std::string(name));
+}
+
+enum class Engine {
+    mcts, greedy, alphabeta
+};
+
+/// Parameters tuned by default for each engine.
+std::vector<std::string> default_params(Engine engine) {
+    switch (engine) {
+        case Engine::mcts:
+            return { "exp_cst", "init_samples", "minimax_weight" };
+        case Engine::greedy:
+            return { "epsilon", "epsilon_mid_ply", "epsilon_mid_factor",
+                     "epsilon_late_ply", "epsilon_late_factor", "init_samples" };
+        default:
+            return { "eval.lever", "eval.structure", "eval.material", "eval.phalanx",
+                     "eval.runner_in_3", "eval.threatened", "eval.threatened_weight" };
+    }
+}
+
+/**
+ * An engine configured from a Config. Its evaluation weights are
+ * set on the thread before each of its moves, so that both players
+ * of a game may use their own.
+ */
+class Player {
+public:
+    Player(Engine engine, const Config& config, Game& game) : weights{ config.eval } {
+        if (engine == Engine::mcts) {
+            mcts = std::make_unique<Mcts>(game);
+            mcts->set_n_iterations(config.iterations);
+            mcts->set_time_limit(config.time_ms);
+            mcts->set_exp_cst(config.exp_cst);
+            mcts->set_n_init_samples(config.init_samples);
+            mcts->set_adaptive_samples(config.adaptive_samples);
+            mcts->set_minimax_weight(config.minimax_weight);
+            mcts->set_transposition_stats(config.transposition_stats);
+            mcts->set_symmetry(config.symmetry);
+            mcts->set_memory_budget(config.memory_budget_mb);
+            mcts->set_expansion_threshold(config.expansion_threshold);
+            mcts->set_root_policy(config.root_policy == "sequential_halving"
+                                  ? RootPolicy::sequential_halving
+                                  : RootPolicy::ucb);
+            mcts->set_solver_threshold(config.solver_threshold);
+        }
+        else if (engine == Engine::greedy) {
+            agent = std::make_unique<Agent>(game);
+            agent->set_n_iterations(config.iterations);
+            agent->set_time_limit(config.time_ms);
+            agent->set_epsilon(config.epsilon);
+            agent->set_epsilon_schedule(config.epsilon_mid_ply, config.epsilon_mid_factor,
+                                        config.epsilon_late_ply, config.epsilon_late_factor);
+            agent->set_n_initial_samples(config.init_samples);
+            agent->set_adaptive_samples(config.adaptive_samples);
+            agent->set_solver_threshold(config.solver_threshold);
+        }
+        else {
+            alphabeta = std::make_unique<AlphaBeta>(game);
+            if (config.time_ms > 0)
+                alphabeta->set_time_limit(config.time_ms);
+        }
+    }
+
+    Action best_action() {
+        set_eval_weights(weights);
+        return mcts ? mcts->best_action()
+             : agent ? agent->best_action()
+             : alphabeta->best_action();
+    }
+
+private:
+    EvalWeights weights;
+    std::unique_ptr<Mcts> mcts;
+    std::unique_ptr<Agent> agent;
+    std::unique_ptr<AlphaBeta> alphabeta;
+};
+
+/**
+ * Play @n_games games between @plus and @minus over @n_threads threads,
+ * each opening being played with both colors. Return the number of
+ * wins of @plus.
+ */
+int play_games(Engine engine, const Config& plus, const Config& minus,
+               int n_games, int n_threads, int opening_plies, unsigned seed) {
+    std::atomic<int> next_game{ 0 };
+    std::atomic<int> plus_wins{ 0 };
+
+    auto worker = [&] {
+        Game game;
+        StateData states[max_depth];
+        std::vector<Action> actions;
+
+        for (int g = next_game++; g < n_games; g = next_game++) {
+            game.reset();
+            StateData* sd = &states[0];
+
+            std::mt19937 eng{ seed + unsigned(g / 2) };
+            for (int i = 0; i < opening_plies && !game.is_lost(); ++i) {
+                game.compute_valid_actions(actions);
+                game.apply(actions[eng() % actions.size()], *sd++);
+            }
+
+            Color plus_color = g & 1 ? Color::black : Color::white;
+            Random::set_thread_stream(seed + unsigned(g));
+            Player plus_player{ engine, plus, game };
+            Player minus_player{ engine, minus, game };
+
+            while (!game.is_lost() && game.pieces(game.player_to_move())) {
+                Player& player = game.player_to_move() == plus_color ? plus_player : minus_player;
+                game.apply(player.best_action(), *sd++);
+            }
+
+            if (game.player_to_move() != plus_color)
+                ++plus_wins;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; ++t)
+        threads.emplace_back(worker);
+    for (auto& t : threads)
+        t.join();
+
+    return plus_wins;
+}
+
+int main(int argc, char *argv[]) {
+    Engine engine = Engine::mcts;
+    std::vector<std::string> names;
+    std::string config_fp = "default_config.json";
+    std::string output_fp = "tuned_config.json";
+    int n_iterations = default_n_iterations;
+    int n_threads = std::max(1u, std::thread::hardware_concurrency());
+    int n_games = 0;
+    int time_ms = -1;
+    int opening_plies = default_opening_plies;
+    double a = default_a, c = default_c;
+    unsigned seed = 2022;
+
+    Config config;
+    std::vector<Param> params;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&] {
+                if (i + 1 >= argc)
+                    throw std::invalid_argument("missing value after " + arg);
+                return std::string(argv[++i]);
+            };
+
+            if (arg == "--engine") {
+                std::string e = value();
+                engine = e == "mcts" ? Engine::mcts
+                       : e == "greedy" ? Engine::greedy
+                       : e == "alphabeta" ? Engine::alphabeta
+                       : throw std::invalid_argument("unknown engine " + e);
+            }
+            else if (arg == "--params") {
+                std::string list = value();
+                for (size_t begin = 0; begin <= list.size(); ) {
+                    size_t end = std::min(list.find(',', begin), list.size());
+                    names.push_back(list.substr(begin, end - begin));
+                    begin = end + 1;
+                }
+            }
+            else if (arg == "--config")        config_fp = value();
+            else if (arg == "--output")        output_fp = value();
+            else if (arg == "--iterations")    n_iterations = std::stoi(value());
+            else if (arg == "--games")         n_games = std::stoi(value());
+            else if (arg == "--threads")       n_threads = std::max(1, std::stoi(value()));
+            else if (arg == "--time-ms")       time_ms = std::stoi(value());
+            else if (arg == "--opening-plies") opening_plies = std::stoi(value());
+            else if (arg == "--a")             a = std::stod(value());
+            else if (arg == "--c")             c = std::stod(value());
+            else if (arg == "--seed")          seed = std::stoul(value());
+            else                               throw std::invalid_argument("unknown option " + arg);
+        }
+
+        if (!config.load(config_fp))
+            throw std::invalid_argument("cannot load " + config_fp);
+        if (names.empty())
+            names = default_params(engine);
+        for (const auto& name : names)
+            params.push_back(param_of(name));
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n\n" << usage;
+        return EXIT_FAILURE;
+    }
+
+    if (time_ms >= 0)
+        config.time_ms = time_ms;
+    if (n_games <= 0)
+        n_games = 2 * n_threads;
+    // Each opening is played with both colors
+    n_games += n_games & 1;
+
+    Game::init();
+
+    // The parameters are tuned in [0, 1], mapped linearly to their range
+    std::vector<double> theta;
+    for (const Param& p : params)
+        theta.push_back(std::clamp((*config.get(p.name) - p.min) / (p.max - p.min), 0.0, 1.0));
+
+    auto configured = [&](const std::vector<double>& values) {
+        Config ret = config;
+        for (size_t i = 0; i < params.size(); ++i)
+            ret.set(params[i].name, params[i].min + values[i] * (params[i].max - params[i].min));
+        return ret;
+    };
+
+    // Usual SPSA gain sequences, with a stability constant of a tenth of the iterations
+    const double A = 0.1 * n_iterations;
+    std::mt19937 eng{ seed };
+    Random::set_seed(seed);
+    auto start = std::chrono::steady_clock::now();
+
+    for (int k = 0; k < n_iterations; ++k) {
+        double ck = c / std::pow(k + 1, 0.101);
+        double ak = a * std::pow((A + 1) / (k + 1 + A), 0.602);
+
+        std::vector<double> delta(params.size()), plus(params.size()), minus(params.size());
+        for (size_t i = 0; i < params.size(); ++i) {
+            delta[i] = eng() & 1 ? 1.0 : -1.0;
+            plus[i] = std::clamp(theta[i] + ck * delta[i], 0.0, 1.0);
+            minus[i] = std::clamp(theta[i] - ck * delta[i], 0.0, 1.0);
+        }
+
+        int wins = play_games(engine, configured(plus), configured(minus),
+                              n_games, n_threads, opening_plies, seed + unsigned(k) * n_games);
+        double diff = (2.0 * wins - n_games) / n_games;
+
+        for (size_t i = 0; i < params.size(); ++i)
+            theta[i] = std::clamp(theta[i] + ak * diff * delta[i] / (2 * ck), 0.0, 1.0);
+
+        Config tuned = configured(theta);
+        std::cerr << "Iteration " << k + 1 << ": plus won " << wins << "/" << n_games << " ";
+        for (const Param& p : params)
+            std::cerr << ' ' << p.name << '=' << std::setprecision(4) << *tuned.get(p.name);
+        std::cerr << std::endl;
+
+        if (!tuned.save(output_fp)) {
+            std::cerr << "Failed to write " << output_fp << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    Config tuned = configured(theta);
+    std::cout << "Tuned parameters (" << n_iterations << " iterations of " << n_games << " games, "
+              << std::chrono::duration_cast<std::chrono::seconds>(
+                     std::chrono::steady_clock::now() - start).count() << "s):\n";
+    for (const Param& p : params)
+        std::cout << "    " << p.name << ": " << *tuned.get(p.name) << '\n';
+    std::cout << "Written to " << output_fp << std::endl;
+}